@@ -0,0 +1,82 @@
+// Generated by tools/animations.py. Do not edit; change the script and rerun it.
+
+#include "RingAnimation.h"
+
+const uint8_t ANIMATION_PALETTE[ANIMATION_PALETTE_SIZE][3] PROGMEM = {
+	{   0,   0,   0 },		// TRANSPARENT
+	{   0,   0,   0 },		// BLACK
+	{ 255, 128, 128 },		// FLASH
+	{  40,  20,  20 },		// FLASH_DIM
+	{   3,  12,   6 },		// SPINNER
+	{   1,   3,   1 },		// SPINNER_TAIL
+	{  30,  18,   0 },		// SWEEP
+	{   6,   3,   0 },		// SWEEP_TAIL
+};
+
+const uint8_t ANIMATION_FIX_FLASH[] PROGMEM = {
+	4, 1, 255, 2, 8, 1, 255, 3, 1, 1, 255, 0, 0,
+};
+
+const uint8_t ANIMATION_ACQUISITION_SPINNER[] PROGMEM = {
+	2, 3, 19, 0, 20, 5, 21, 4, 2, 3, 20, 0, 21, 5, 22, 4,
+	2, 3, 21, 0, 22, 5, 23, 4, 2, 3, 22, 0, 23, 5, 24, 4,
+	2, 3, 23, 0, 24, 5, 25, 4, 2, 3, 24, 0, 25, 5, 26, 4,
+	2, 3, 25, 0, 26, 5, 27, 4, 2, 3, 26, 0, 27, 5, 28, 4,
+	2, 3, 27, 0, 28, 5, 29, 4, 2, 3, 28, 0, 29, 5, 30, 4,
+	2, 3, 29, 0, 30, 5, 31, 4, 2, 3, 30, 0, 31, 5, 32, 4,
+	2, 3, 31, 0, 32, 5, 33, 4, 2, 3, 32, 0, 33, 5, 34, 4,
+	2, 3, 33, 0, 34, 5, 35, 4, 2, 3, 34, 0, 35, 5, 36, 4,
+	2, 3, 35, 0, 36, 5, 37, 4, 2, 3, 36, 0, 37, 5, 38, 4,
+	2, 3, 37, 0, 38, 5, 39, 4, 2, 3, 38, 0, 39, 5, 40, 4,
+	2, 3, 39, 0, 40, 5, 41, 4, 2, 3, 40, 0, 41, 5, 42, 4,
+	2, 3, 41, 0, 42, 5, 43, 4, 2, 3, 42, 0, 43, 5, 44, 4,
+	2, 3, 43, 0, 44, 5, 45, 4, 2, 3, 44, 0, 45, 5, 46, 4,
+	2, 3, 45, 0, 46, 5, 47, 4, 2, 3, 46, 0, 47, 5, 48, 4,
+	2, 3, 47, 0, 48, 5, 49, 4, 2, 3, 48, 0, 49, 5, 50, 4,
+	2, 3, 49, 0, 50, 5, 51, 4, 2, 3, 50, 0, 51, 5, 52, 4,
+	2, 3, 51, 0, 52, 5, 53, 4, 2, 3, 52, 0, 53, 5, 54, 4,
+	2, 3, 53, 0, 54, 5, 55, 4, 2, 3, 54, 0, 55, 5, 56, 4,
+	2, 3, 55, 0, 56, 5, 57, 4, 2, 3, 56, 0, 57, 5, 58, 4,
+	2, 3, 57, 0, 58, 5, 59, 4, 2, 3, 0, 4, 58, 0, 59, 5,
+	2, 3, 0, 5, 1, 4, 59, 0, 2, 3, 0, 0, 1, 5, 2, 4,
+	2, 3, 1, 0, 2, 5, 3, 4, 2, 3, 2, 0, 3, 5, 4, 4,
+	2, 3, 3, 0, 4, 5, 5, 4, 2, 3, 4, 0, 5, 5, 6, 4,
+	2, 3, 5, 0, 6, 5, 7, 4, 2, 3, 6, 0, 7, 5, 8, 4,
+	2, 3, 7, 0, 8, 5, 9, 4, 2, 3, 8, 0, 9, 5, 10, 4,
+	2, 3, 9, 0, 10, 5, 11, 4, 2, 3, 10, 0, 11, 5, 12, 4,
+	2, 3, 11, 0, 12, 5, 13, 4, 2, 3, 12, 0, 13, 5, 14, 4,
+	2, 3, 13, 0, 14, 5, 15, 4, 2, 3, 14, 0, 15, 5, 16, 4,
+	2, 3, 15, 0, 16, 5, 17, 4, 2, 3, 16, 0, 17, 5, 18, 4,
+	2, 3, 17, 0, 18, 5, 19, 4, 2, 3, 18, 0, 19, 5, 20, 4,
+	0,
+};
+
+const uint8_t ANIMATION_MINUTE_TRANSITION[] PROGMEM = {
+	1, 2, 21, 6, 22, 6, 1, 4, 21, 7, 22, 7, 23, 6, 24, 6,
+	1, 6, 21, 0, 22, 0, 23, 7, 24, 7, 25, 6, 26, 6, 1, 6,
+	23, 0, 24, 0, 25, 7, 26, 7, 27, 6, 28, 6, 1, 6, 25, 0,
+	26, 0, 27, 7, 28, 7, 29, 6, 30, 6, 1, 6, 27, 0, 28, 0,
+	29, 7, 30, 7, 31, 6, 32, 6, 1, 6, 29, 0, 30, 0, 31, 7,
+	32, 7, 33, 6, 34, 6, 1, 6, 31, 0, 32, 0, 33, 7, 34, 7,
+	35, 6, 36, 6, 1, 6, 33, 0, 34, 0, 35, 7, 36, 7, 37, 6,
+	38, 6, 1, 6, 35, 0, 36, 0, 37, 7, 38, 7, 39, 6, 40, 6,
+	1, 6, 37, 0, 38, 0, 39, 7, 40, 7, 41, 6, 42, 6, 1, 6,
+	39, 0, 40, 0, 41, 7, 42, 7, 43, 6, 44, 6, 1, 6, 41, 0,
+	42, 0, 43, 7, 44, 7, 45, 6, 46, 6, 1, 6, 43, 0, 44, 0,
+	45, 7, 46, 7, 47, 6, 48, 6, 1, 6, 45, 0, 46, 0, 47, 7,
+	48, 7, 49, 6, 50, 6, 1, 6, 47, 0, 48, 0, 49, 7, 50, 7,
+	51, 6, 52, 6, 1, 6, 49, 0, 50, 0, 51, 7, 52, 7, 53, 6,
+	54, 6, 1, 6, 51, 0, 52, 0, 53, 7, 54, 7, 55, 6, 56, 6,
+	1, 6, 53, 0, 54, 0, 55, 7, 56, 7, 57, 6, 58, 6, 1, 6,
+	0, 6, 55, 0, 56, 0, 57, 7, 58, 7, 59, 6, 1, 6, 0, 7,
+	1, 6, 2, 6, 57, 0, 58, 0, 59, 7, 1, 6, 0, 0, 1, 7,
+	2, 7, 3, 6, 4, 6, 59, 0, 1, 6, 1, 0, 2, 0, 3, 7,
+	4, 7, 5, 6, 6, 6, 1, 6, 3, 0, 4, 0, 5, 7, 6, 7,
+	7, 6, 8, 6, 1, 6, 5, 0, 6, 0, 7, 7, 8, 7, 9, 6,
+	10, 6, 1, 6, 7, 0, 8, 0, 9, 7, 10, 7, 11, 6, 12, 6,
+	1, 6, 9, 0, 10, 0, 11, 7, 12, 7, 13, 6, 14, 6, 1, 6,
+	11, 0, 12, 0, 13, 7, 14, 7, 15, 6, 16, 6, 1, 6, 13, 0,
+	14, 0, 15, 7, 16, 7, 17, 6, 18, 6, 1, 6, 15, 0, 16, 0,
+	17, 7, 18, 7, 19, 6, 20, 6, 1, 4, 17, 0, 18, 0, 19, 7,
+	20, 7, 1, 2, 19, 0, 20, 0, 1, 0, 0,
+};
@@ -0,0 +1,79 @@
+#include "Brightness.h"
+
+// Fade curve: 255 * (i/32)^2.2
+const uint8_t FADE_CURVE[Brightness::fadeSteps + 1] PROGMEM = {
+	0, 0, 1, 1, 3, 4, 6, 9, 12, 16, 20, 24, 29, 35, 41, 48,
+	55, 63, 72, 81, 91, 101, 112, 123, 135, 148, 161, 175, 190, 205, 221, 238,
+	255
+};
+
+Brightness::Brightness(uint8_t level) {
+	master = level;
+
+	// Start dark, for fadeIn().
+	position = 0;
+	target = 0;
+	ticksPerStep = 1;
+	countdown = 0;
+}
+
+void Brightness::setMaster(uint8_t level) {
+	master = level;
+}
+
+uint8_t Brightness::getMaster() {
+	return master;
+}
+
+// Fade up to the master level, from wherever the last fade got to.
+void Brightness::fadeIn(uint8_t ticks) {
+	target = fadeSteps;
+	ticksPerStep = ticks;
+	countdown = ticks;
+}
+
+// Fade down to dark.
+void Brightness::fadeOut(uint8_t ticks) {
+	target = 0;
+	ticksPerStep = ticks;
+	countdown = ticks;
+}
+
+bool Brightness::isFading() {
+	return position != target;
+}
+
+// Advance the fade. Call once per tick. Returns true when the levels changed.
+bool Brightness::tick() {
+	if (position == target  ||  --countdown > 0)
+		return false;
+
+	countdown = ticksPerStep;
+	if (position < target)
+		position++;
+	else
+		position--;
+
+	return true;
+}
+
+uint8_t Brightness::getTubeLevel() {
+	uint8_t fade = pgm_read_byte(&FADE_CURVE[position]);
+	return ((uint16_t)master * (fade + 1)) >> 8;
+}
+
+uint8_t Brightness::getPixelScale() {
+	uint16_t scale = (uint16_t)getTubeLevel() * 255 / defaultMaster;
+	return scale > 255 ? 255 : scale;
+}
+
+uint32_t scaleColor(uint32_t color, uint8_t scale) {
+	if (scale == 255)
+		return color;
+
+	uint16_t factor = scale + 1;
+	uint8_t r = ((uint8_t)(color >> 16) * factor) >> 8;
+	uint8_t g = ((uint8_t)(color >> 8) * factor) >> 8;
+	uint8_t b = ((uint8_t)color * factor) >> 8;
+	return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+}
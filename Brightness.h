@@ -0,0 +1,51 @@
+#ifndef Brightness_h
+#define Brightness_h
+
+#include <Arduino.h>
+
+#ifndef PROGMEM
+	// Host build: tables live in ordinary memory.
+	#define PROGMEM
+	#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#endif
+
+// One brightness for the tubes and the pixels: a master level set by the user, and a fade
+// applied on top of it. Fades follow a perceptual curve from a table, one step every few
+// ticks, so tick() is cheap enough to call from the tick ISR.
+//
+// The master level is the tube PWM value, 0 - 255. Pixel colors are designed to look
+// right against the tubes at defaultMaster, and scale with the master level from there.
+class Brightness {
+
+	public:
+		static const uint8_t defaultMaster = 170;
+		static const uint8_t fadeSteps = 32;
+
+		Brightness(uint8_t master);
+
+		void setMaster(uint8_t level);
+		uint8_t getMaster();
+
+		void fadeIn(uint8_t ticksPerStep);
+		void fadeOut(uint8_t ticksPerStep);
+		bool isFading();
+
+		bool tick();
+
+		uint8_t getTubeLevel();
+		uint8_t getPixelScale();
+
+	private:
+		uint8_t master;
+
+		// Position on the fade curve, 0 (dark) to fadeSteps (full), and where it's going
+		uint8_t position;
+		uint8_t target;
+		uint8_t ticksPerStep;
+		uint8_t countdown;
+};
+
+// Scale a packed pixel color by a pixel scale, 0 - 255.
+uint32_t scaleColor(uint32_t color, uint8_t scale);
+
+#endif
@@ -0,0 +1,38 @@
+#include "Calendar.h"
+
+// Number of days in the year before the first of each month, plus the length of the
+// year, for common and leap years.
+const uint16_t MONTH_START[2][13] PROGMEM = {
+	{ 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365 },
+	{ 0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335, 366 }
+};
+
+// Gregorian leap year rule.
+bool isLeapYear(uint16_t year) {
+	return (year % 4 == 0  &&  year % 100 != 0)  ||  year % 400 == 0;
+}
+
+// Convert a day of the year (1 = January 1) to month (1-12) and day of the month (1-31),
+// in constant time. Since every month has 28 to 31 days, dividing the zero-based day
+// by 32 gives either the right month or the one before it, so one table comparison
+// settles it.
+void dayOfYearToDate(uint16_t dayOfYear, bool leapYear, uint8_t *month, uint8_t *day) {
+	const uint16_t *start = MONTH_START[leapYear ? 1 : 0];
+	uint16_t d = dayOfYear - 1;
+
+	uint8_t m = d >> 5;
+	if (d >= pgm_read_word(start + m + 1))
+		m++;
+
+	*month = m + 1;
+	*day = d - pgm_read_word(start + m) + 1;
+}
+
+// Day of the week (0 = Sunday) for a day of the year (1 = January 1). Finds the
+// weekday of January 1 with Gauss's formula, and counts on from there.
+uint8_t dayOfWeek(uint16_t year, uint16_t dayOfYear) {
+	uint16_t y = year - 1;
+	uint8_t january1 = (1 + 5*(y % 4) + 4*(y % 100) + 6*(y % 400)) % 7;
+
+	return (january1 + dayOfYear - 1) % 7;
+}
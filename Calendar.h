@@ -0,0 +1,16 @@
+#ifndef Calendar_h
+#define Calendar_h
+
+#include <Arduino.h>
+
+#ifndef PROGMEM
+	// Host build: tables live in ordinary memory.
+	#define PROGMEM
+	#define pgm_read_word(p) (*(const uint16_t *)(p))
+#endif
+
+bool isLeapYear(uint16_t year);
+void dayOfYearToDate(uint16_t dayOfYear, bool leapYear, uint8_t *month, uint8_t *day);
+uint8_t dayOfWeek(uint16_t year, uint16_t dayOfYear);
+
+#endif
@@ -0,0 +1,109 @@
+#include "CathodeCare.h"
+#include <EEPROM.h>
+
+// Marks a valid block of usage counts in EEPROM.
+const uint8_t CATHODE_CARE_MAGIC = 0xc5;
+
+CathodeCare::CathodeCare() {
+	for (uint8_t i=0;  i<NIXIE_CATHODES;  i++)
+		usage[i] = 0;
+
+	for (uint8_t tube=0;  tube<NIXIE_TUBES;  tube++)
+		for (uint8_t step=0;  step<exerciseSteps;  step++)
+			exercise[tube][step] = NIXIE_NO_CATHODE;
+}
+
+// Count one unit of use for every cathode lit in the frame.
+void CathodeCare::account(const volatile uint8_t *frame) {
+	for (uint8_t i=0;  i<6;  i++) {
+		uint8_t bits = frame[i];
+		for (uint8_t cathode = i*8;  bits != 0;  cathode++, bits >>= 1) {
+			if (bits & 0x01)
+				increment(cathode);
+		}
+	}
+}
+
+// Choose the least used cathodes of each tube for the next exercise, and count
+// the use they will get.
+void CathodeCare::planExercise() {
+	for (uint8_t tube=0;  tube<NIXIE_TUBES;  tube++) {
+		for (uint8_t step=0;  step<exerciseSteps;  step++) {
+			// Selection: least used cathode not already chosen.
+			uint8_t best = NIXIE_NO_CATHODE;
+			for (uint8_t digit=0;  digit<10;  digit++) {
+				uint8_t cathode = pgm_read_byte(&NIXIE_TUBE_CATHODES[tube][digit]);
+				if (cathode == NIXIE_NO_CATHODE)
+					continue;
+
+				bool chosen = false;
+				for (uint8_t i=0;  i<step;  i++)
+					if (exercise[tube][i] == cathode)
+						chosen = true;
+
+				if (!chosen  &&  (best == NIXIE_NO_CATHODE  ||  usage[cathode] < usage[best]))
+					best = cathode;
+			}
+
+			exercise[tube][step] = best;
+			if (best != NIXIE_NO_CATHODE)
+				increment(best);
+		}
+	}
+}
+
+// Build the frame for one step of the planned exercise: one cathode lit per tube.
+void CathodeCare::exerciseFrame(uint8_t step, volatile uint8_t *frame) {
+	for (uint8_t i=0;  i<6;  i++)
+		frame[i] = 0;
+
+	for (uint8_t tube=0;  tube<NIXIE_TUBES;  tube++) {
+		uint8_t cathode = exercise[tube][step];
+		if (cathode != NIXIE_NO_CATHODE)
+			frame[cathode >> 3] |= 1 << (cathode & 0x07);
+	}
+}
+
+uint16_t CathodeCare::getUsage(uint8_t cathode) {
+	return usage[cathode];
+}
+
+// Queue the usage counts for writing to EEPROM, at the given address. Only bytes that
+// changed are written. Uses 1 + 2 * NIXIE_CATHODES bytes, low byte of each count first,
+// as the AVR keeps them. A count that carries into its high byte while being written
+// may be saved off by 256, which does no harm to the choice of exercises.
+//
+// The counts are queued before the magic byte, so the magic is never written over
+// counts that were not. Returns false if the writer's queue couldn't take both; call
+// again later, and the bytes already written are skipped.
+bool CathodeCare::save(EepromWriter *writer, int address) {
+	if (!writer->write(address + 1, usage, sizeof(usage), NULL, NULL))
+		return false;
+
+	return writer->write(address, &CATHODE_CARE_MAGIC, 1, NULL, NULL);
+}
+
+// Read the usage counts from EEPROM. Returns false, leaving the counts alone, when
+// no counts have been saved there.
+bool CathodeCare::load(int address) {
+	if (EEPROM.read(address++) != CATHODE_CARE_MAGIC)
+		return false;
+
+	for (uint8_t i=0;  i<NIXIE_CATHODES;  i++) {
+		uint8_t low = EEPROM.read(address++);
+		uint8_t high = EEPROM.read(address++);
+		usage[i] = (uint16_t)high << 8 | low;
+	}
+
+	return true;
+}
+
+// Count one unit of use, halving all counts first if this one is full.
+void CathodeCare::increment(uint8_t cathode) {
+	if (usage[cathode] == 0xffff) {
+		for (uint8_t i=0;  i<NIXIE_CATHODES;  i++)
+			usage[i] >>= 1;
+	}
+
+	usage[cathode]++;
+}
@@ -0,0 +1,40 @@
+#ifndef CathodeCare_h
+#define CathodeCare_h
+
+#include <Arduino.h>
+#include "NixieSegments.h"
+#include "EepromWriter.h"
+
+// Guards against cathode poisoning. Keeps a usage count for every cathode, from the
+// frames actually shown, and plans short exercise routines that light the least
+// used cathodes of each tube.
+//
+// Counts are roughly in seconds lit. When any count would overflow, all of them are
+// halved, which keeps their proportions.
+class CathodeCare {
+
+	public:
+		// Number of cathodes per tube lit in one exercise, one after the other
+		static const uint8_t exerciseSteps = 3;
+
+		CathodeCare();
+
+		void account(const volatile uint8_t *frame);
+		void planExercise();
+		void exerciseFrame(uint8_t step, volatile uint8_t *frame);
+
+		uint16_t getUsage(uint8_t cathode);
+
+		bool save(EepromWriter *writer, int address);
+		bool load(int address);
+
+	private:
+		uint16_t usage[NIXIE_CATHODES];
+
+		// Cathodes chosen by planExercise(), least used first
+		uint8_t exercise[NIXIE_TUBES][exerciseSteps];
+
+		void increment(uint8_t cathode);
+};
+
+#endif
@@ -0,0 +1,133 @@
+// Generated by tools/colortables.py. Do not edit; change the script and rerun it.
+// Gamma 2.6, peak 96.
+
+#include "ColorTables.h"
+
+// Time of day, one entry per 4 minutes from midnight
+const uint8_t MINUTE_COLORS[MINUTE_COLOR_COUNT][3] PROGMEM = {
+	{  96,   0,   0 }, {  96,   0,   0 }, {  96,   0,   0 }, {  96,   0,   0 }, {  96,   0,   0 }, {  96,   0,   0 },
+	{  96,   0,   0 }, {  96,   0,   0 }, {  96,   0,   1 }, {  96,   0,   1 }, {  96,   0,   1 }, {  96,   0,   1 },
+	{  96,   0,   1 }, {  96,   0,   2 }, {  96,   0,   2 }, {  96,   0,   3 }, {  96,   0,   3 }, {  96,   0,   4 },
+	{  96,   0,   4 }, {  96,   0,   5 }, {  96,   0,   6 }, {  96,   0,   6 }, {  96,   0,   7 }, {  96,   0,   8 },
+	{  96,   0,   9 }, {  96,   0,  10 }, {  96,   0,  11 }, {  96,   0,  12 }, {  96,   0,  13 }, {  96,   0,  14 },
+	{  96,   0,  16 }, {  96,   0,  17 }, {  96,   0,  19 }, {  96,   0,  20 }, {  96,   0,  22 }, {  96,   0,  24 },
+	{  96,   0,  25 }, {  96,   0,  27 }, {  96,   0,  29 }, {  96,   0,  31 }, {  96,   0,  33 }, {  96,   0,  36 },
+	{  96,   0,  38 }, {  96,   0,  40 }, {  96,   0,  43 }, {  96,   0,  45 }, {  96,   0,  48 }, {  96,   0,  51 },
+	{  96,   0,  54 }, {  96,   0,  57 }, {  96,   0,  60 }, {  96,   0,  63 }, {  96,   0,  66 }, {  96,   0,  70 },
+	{  96,   0,  73 }, {  96,   0,  77 }, {  96,   0,  80 }, {  96,   0,  84 }, {  96,   0,  88 }, {  96,   0,  92 },
+	{  96,   0,  96 }, {  92,   0,  96 }, {  88,   0,  96 }, {  84,   0,  96 }, {  80,   0,  96 }, {  77,   0,  96 },
+	{  73,   0,  96 }, {  70,   0,  96 }, {  66,   0,  96 }, {  63,   0,  96 }, {  60,   0,  96 }, {  57,   0,  96 },
+	{  54,   0,  96 }, {  51,   0,  96 }, {  48,   0,  96 }, {  45,   0,  96 }, {  43,   0,  96 }, {  40,   0,  96 },
+	{  38,   0,  96 }, {  36,   0,  96 }, {  33,   0,  96 }, {  31,   0,  96 }, {  29,   0,  96 }, {  27,   0,  96 },
+	{  25,   0,  96 }, {  24,   0,  96 }, {  22,   0,  96 }, {  20,   0,  96 }, {  19,   0,  96 }, {  17,   0,  96 },
+	{  16,   0,  96 }, {  14,   0,  96 }, {  13,   0,  96 }, {  12,   0,  96 }, {  11,   0,  96 }, {  10,   0,  96 },
+	{   9,   0,  96 }, {   8,   0,  96 }, {   7,   0,  96 }, {   6,   0,  96 }, {   6,   0,  96 }, {   5,   0,  96 },
+	{   4,   0,  96 }, {   4,   0,  96 }, {   3,   0,  96 }, {   3,   0,  96 }, {   2,   0,  96 }, {   2,   0,  96 },
+	{   1,   0,  96 }, {   1,   0,  96 }, {   1,   0,  96 }, {   1,   0,  96 }, {   1,   0,  96 }, {   0,   0,  96 },
+	{   0,   0,  96 }, {   0,   0,  96 }, {   0,   0,  96 }, {   0,   0,  96 }, {   0,   0,  96 }, {   0,   0,  96 },
+	{   0,   0,  96 }, {   0,   0,  96 }, {   0,   0,  96 }, {   0,   0,  96 }, {   0,   0,  96 }, {   0,   0,  96 },
+	{   0,   0,  96 }, {   0,   0,  96 }, {   0,   1,  96 }, {   0,   1,  96 }, {   0,   1,  96 }, {   0,   1,  96 },
+	{   0,   1,  96 }, {   0,   2,  96 }, {   0,   2,  96 }, {   0,   3,  96 }, {   0,   3,  96 }, {   0,   4,  96 },
+	{   0,   4,  96 }, {   0,   5,  96 }, {   0,   6,  96 }, {   0,   6,  96 }, {   0,   7,  96 }, {   0,   8,  96 },
+	{   0,   9,  96 }, {   0,  10,  96 }, {   0,  11,  96 }, {   0,  12,  96 }, {   0,  13,  96 }, {   0,  14,  96 },
+	{   0,  16,  96 }, {   0,  17,  96 }, {   0,  19,  96 }, {   0,  20,  96 }, {   0,  22,  96 }, {   0,  24,  96 },
+	{   0,  25,  96 }, {   0,  27,  96 }, {   0,  29,  96 }, {   0,  31,  96 }, {   0,  33,  96 }, {   0,  36,  96 },
+	{   0,  38,  96 }, {   0,  40,  96 }, {   0,  43,  96 }, {   0,  45,  96 }, {   0,  48,  96 }, {   0,  51,  96 },
+	{   0,  54,  96 }, {   0,  57,  96 }, {   0,  60,  96 }, {   0,  63,  96 }, {   0,  66,  96 }, {   0,  70,  96 },
+	{   0,  73,  96 }, {   0,  77,  96 }, {   0,  80,  96 }, {   0,  84,  96 }, {   0,  88,  96 }, {   0,  92,  96 },
+	{   0,  96,  96 }, {   0,  96,  92 }, {   0,  96,  88 }, {   0,  96,  84 }, {   0,  96,  80 }, {   0,  96,  77 },
+	{   0,  96,  73 }, {   0,  96,  70 }, {   0,  96,  66 }, {   0,  96,  63 }, {   0,  96,  60 }, {   0,  96,  57 },
+	{   0,  96,  54 }, {   0,  96,  51 }, {   0,  96,  48 }, {   0,  96,  45 }, {   0,  96,  43 }, {   0,  96,  40 },
+	{   0,  96,  38 }, {   0,  96,  36 }, {   0,  96,  33 }, {   0,  96,  31 }, {   0,  96,  29 }, {   0,  96,  27 },
+	{   0,  96,  25 }, {   0,  96,  24 }, {   0,  96,  22 }, {   0,  96,  20 }, {   0,  96,  19 }, {   0,  96,  17 },
+	{   0,  96,  16 }, {   0,  96,  14 }, {   0,  96,  13 }, {   0,  96,  12 }, {   0,  96,  11 }, {   0,  96,  10 },
+	{   0,  96,   9 }, {   0,  96,   8 }, {   0,  96,   7 }, {   0,  96,   6 }, {   0,  96,   6 }, {   0,  96,   5 },
+	{   0,  96,   4 }, {   0,  96,   4 }, {   0,  96,   3 }, {   0,  96,   3 }, {   0,  96,   2 }, {   0,  96,   2 },
+	{   0,  96,   1 }, {   0,  96,   1 }, {   0,  96,   1 }, {   0,  96,   1 }, {   0,  96,   1 }, {   0,  96,   0 },
+	{   0,  96,   0 }, {   0,  96,   0 }, {   0,  96,   0 }, {   0,  96,   0 }, {   0,  96,   0 }, {   0,  96,   0 },
+	{   0,  96,   0 }, {   0,  96,   0 }, {   0,  96,   0 }, {   0,  96,   0 }, {   0,  96,   0 }, {   0,  96,   0 },
+	{   0,  96,   0 }, {   0,  96,   0 }, {   1,  96,   0 }, {   1,  96,   0 }, {   1,  96,   0 }, {   1,  96,   0 },
+	{   1,  96,   0 }, {   2,  96,   0 }, {   2,  96,   0 }, {   3,  96,   0 }, {   3,  96,   0 }, {   4,  96,   0 },
+	{   4,  96,   0 }, {   5,  96,   0 }, {   6,  96,   0 }, {   6,  96,   0 }, {   7,  96,   0 }, {   8,  96,   0 },
+	{   9,  96,   0 }, {  10,  96,   0 }, {  11,  96,   0 }, {  12,  96,   0 }, {  13,  96,   0 }, {  14,  96,   0 },
+	{  16,  96,   0 }, {  17,  96,   0 }, {  19,  96,   0 }, {  20,  96,   0 }, {  22,  96,   0 }, {  24,  96,   0 },
+	{  25,  96,   0 }, {  27,  96,   0 }, {  29,  96,   0 }, {  31,  96,   0 }, {  33,  96,   0 }, {  36,  96,   0 },
+	{  38,  96,   0 }, {  40,  96,   0 }, {  43,  96,   0 }, {  45,  96,   0 }, {  48,  96,   0 }, {  51,  96,   0 },
+	{  54,  96,   0 }, {  57,  96,   0 }, {  60,  96,   0 }, {  63,  96,   0 }, {  66,  96,   0 }, {  70,  96,   0 },
+	{  73,  96,   0 }, {  77,  96,   0 }, {  80,  96,   0 }, {  84,  96,   0 }, {  88,  96,   0 }, {  92,  96,   0 },
+	{  96,  96,   0 }, {  96,  92,   0 }, {  96,  88,   0 }, {  96,  84,   0 }, {  96,  80,   0 }, {  96,  77,   0 },
+	{  96,  73,   0 }, {  96,  70,   0 }, {  96,  66,   0 }, {  96,  63,   0 }, {  96,  60,   0 }, {  96,  57,   0 },
+	{  96,  54,   0 }, {  96,  51,   0 }, {  96,  48,   0 }, {  96,  45,   0 }, {  96,  43,   0 }, {  96,  40,   0 },
+	{  96,  38,   0 }, {  96,  36,   0 }, {  96,  33,   0 }, {  96,  31,   0 }, {  96,  29,   0 }, {  96,  27,   0 },
+	{  96,  25,   0 }, {  96,  24,   0 }, {  96,  22,   0 }, {  96,  20,   0 }, {  96,  19,   0 }, {  96,  17,   0 },
+	{  96,  16,   0 }, {  96,  14,   0 }, {  96,  13,   0 }, {  96,  12,   0 }, {  96,  11,   0 }, {  96,  10,   0 },
+	{  96,   9,   0 }, {  96,   8,   0 }, {  96,   7,   0 }, {  96,   6,   0 }, {  96,   6,   0 }, {  96,   5,   0 },
+	{  96,   4,   0 }, {  96,   4,   0 }, {  96,   3,   0 }, {  96,   3,   0 }, {  96,   2,   0 }, {  96,   2,   0 },
+	{  96,   1,   0 }, {  96,   1,   0 }, {  96,   1,   0 }, {  96,   1,   0 }, {  96,   1,   0 }, {  96,   0,   0 },
+	{  96,   0,   0 }, {  96,   0,   0 }, {  96,   0,   0 }, {  96,   0,   0 }, {  96,   0,   0 }, {  96,   0,   0 },
+};
+
+// Day of year, from day 1
+const uint8_t DAY_COLORS[DAY_COLOR_COUNT][3] PROGMEM = {
+	{  96,   0,   0 }, {  96,   0,   0 }, {  96,   0,   0 }, {  96,   0,   0 }, {  96,   0,   0 }, {  96,   0,   0 },
+	{  96,   0,   0 }, {  96,   0,   0 }, {  96,   1,   0 }, {  96,   1,   0 }, {  96,   1,   0 }, {  96,   1,   0 },
+	{  96,   2,   0 }, {  96,   2,   0 }, {  96,   3,   0 }, {  96,   3,   0 }, {  96,   3,   0 }, {  96,   4,   0 },
+	{  96,   5,   0 }, {  96,   5,   0 }, {  96,   6,   0 }, {  96,   7,   0 }, {  96,   8,   0 }, {  96,   8,   0 },
+	{  96,   9,   0 }, {  96,  10,   0 }, {  96,  12,   0 }, {  96,  13,   0 }, {  96,  14,   0 }, {  96,  15,   0 },
+	{  96,  17,   0 }, {  96,  18,   0 }, {  96,  19,   0 }, {  96,  21,   0 }, {  96,  23,   0 }, {  96,  24,   0 },
+	{  96,  26,   0 }, {  96,  28,   0 }, {  96,  30,   0 }, {  96,  32,   0 }, {  96,  34,   0 }, {  96,  36,   0 },
+	{  96,  39,   0 }, {  96,  41,   0 }, {  96,  44,   0 }, {  96,  46,   0 }, {  96,  49,   0 }, {  96,  51,   0 },
+	{  96,  54,   0 }, {  96,  57,   0 }, {  96,  60,   0 }, {  96,  63,   0 }, {  96,  67,   0 }, {  96,  70,   0 },
+	{  96,  73,   0 }, {  96,  77,   0 }, {  96,  80,   0 }, {  96,  84,   0 }, {  96,  88,   0 }, {  96,  92,   0 },
+	{  96,  96,   0 }, {  92,  96,   0 }, {  88,  96,   0 }, {  84,  96,   0 }, {  80,  96,   0 }, {  77,  96,   0 },
+	{  73,  96,   0 }, {  70,  96,   0 }, {  67,  96,   0 }, {  63,  96,   0 }, {  60,  96,   0 }, {  57,  96,   0 },
+	{  54,  96,   0 }, {  51,  96,   0 }, {  49,  96,   0 }, {  46,  96,   0 }, {  44,  96,   0 }, {  41,  96,   0 },
+	{  39,  96,   0 }, {  36,  96,   0 }, {  34,  96,   0 }, {  32,  96,   0 }, {  30,  96,   0 }, {  28,  96,   0 },
+	{  26,  96,   0 }, {  24,  96,   0 }, {  23,  96,   0 }, {  21,  96,   0 }, {  19,  96,   0 }, {  18,  96,   0 },
+	{  17,  96,   0 }, {  15,  96,   0 }, {  14,  96,   0 }, {  13,  96,   0 }, {  12,  96,   0 }, {  10,  96,   0 },
+	{   9,  96,   0 }, {   8,  96,   0 }, {   8,  96,   0 }, {   7,  96,   0 }, {   6,  96,   0 }, {   5,  96,   0 },
+	{   5,  96,   0 }, {   4,  96,   0 }, {   3,  96,   0 }, {   3,  96,   0 }, {   3,  96,   0 }, {   2,  96,   0 },
+	{   2,  96,   0 }, {   1,  96,   0 }, {   1,  96,   0 }, {   1,  96,   0 }, {   1,  96,   0 }, {   0,  96,   0 },
+	{   0,  96,   0 }, {   0,  96,   0 }, {   0,  96,   0 }, {   0,  96,   0 }, {   0,  96,   0 }, {   0,  96,   0 },
+	{   0,  96,   0 }, {   0,  96,   0 }, {   0,  96,   0 }, {   0,  96,   0 }, {   0,  96,   0 }, {   0,  96,   0 },
+	{   0,  96,   0 }, {   0,  96,   0 }, {   0,  96,   0 }, {   0,  96,   0 }, {   0,  96,   1 }, {   0,  96,   1 },
+	{   0,  96,   1 }, {   0,  96,   1 }, {   0,  96,   2 }, {   0,  96,   2 }, {   0,  96,   3 }, {   0,  96,   3 },
+	{   0,  96,   3 }, {   0,  96,   4 }, {   0,  96,   5 }, {   0,  96,   5 }, {   0,  96,   6 }, {   0,  96,   7 },
+	{   0,  96,   8 }, {   0,  96,   8 }, {   0,  96,   9 }, {   0,  96,  10 }, {   0,  96,  12 }, {   0,  96,  13 },
+	{   0,  96,  14 }, {   0,  96,  15 }, {   0,  96,  17 }, {   0,  96,  18 }, {   0,  96,  19 }, {   0,  96,  21 },
+	{   0,  96,  23 }, {   0,  96,  24 }, {   0,  96,  26 }, {   0,  96,  28 }, {   0,  96,  30 }, {   0,  96,  32 },
+	{   0,  96,  34 }, {   0,  96,  36 }, {   0,  96,  39 }, {   0,  96,  41 }, {   0,  96,  44 }, {   0,  96,  46 },
+	{   0,  96,  49 }, {   0,  96,  51 }, {   0,  96,  54 }, {   0,  96,  57 }, {   0,  96,  60 }, {   0,  96,  63 },
+	{   0,  96,  67 }, {   0,  96,  70 }, {   0,  96,  73 }, {   0,  96,  77 }, {   0,  96,  80 }, {   0,  96,  84 },
+	{   0,  96,  88 }, {   0,  96,  92 }, {   0,  96,  96 }, {   0,  92,  96 }, {   0,  88,  96 }, {   0,  84,  96 },
+	{   0,  80,  96 }, {   0,  77,  96 }, {   0,  73,  96 }, {   0,  70,  96 }, {   0,  67,  96 }, {   0,  63,  96 },
+	{   0,  60,  96 }, {   0,  57,  96 }, {   0,  54,  96 }, {   0,  51,  96 }, {   0,  49,  96 }, {   0,  46,  96 },
+	{   0,  44,  96 }, {   0,  41,  96 }, {   0,  39,  96 }, {   0,  36,  96 }, {   0,  34,  96 }, {   0,  32,  96 },
+	{   0,  30,  96 }, {   0,  28,  96 }, {   0,  26,  96 }, {   0,  24,  96 }, {   0,  23,  96 }, {   0,  21,  96 },
+	{   0,  19,  96 }, {   0,  18,  96 }, {   0,  17,  96 }, {   0,  15,  96 }, {   0,  14,  96 }, {   0,  13,  96 },
+	{   0,  12,  96 }, {   0,  10,  96 }, {   0,   9,  96 }, {   0,   8,  96 }, {   0,   8,  96 }, {   0,   7,  96 },
+	{   0,   6,  96 }, {   0,   5,  96 }, {   0,   5,  96 }, {   0,   4,  96 }, {   0,   3,  96 }, {   0,   3,  96 },
+	{   0,   3,  96 }, {   0,   2,  96 }, {   0,   2,  96 }, {   0,   1,  96 }, {   0,   1,  96 }, {   0,   1,  96 },
+	{   0,   1,  96 }, {   0,   0,  96 }, {   0,   0,  96 }, {   0,   0,  96 }, {   0,   0,  96 }, {   0,   0,  96 },
+	{   0,   0,  96 }, {   0,   0,  96 }, {   0,   0,  96 }, {   0,   0,  96 }, {   0,   0,  96 }, {   0,   0,  96 },
+	{   0,   0,  96 }, {   0,   0,  96 }, {   0,   0,  96 }, {   0,   0,  96 }, {   0,   0,  96 }, {   0,   0,  96 },
+	{   1,   0,  96 }, {   1,   0,  96 }, {   1,   0,  96 }, {   1,   0,  96 }, {   2,   0,  96 }, {   2,   0,  96 },
+	{   3,   0,  96 }, {   3,   0,  96 }, {   3,   0,  96 }, {   4,   0,  96 }, {   5,   0,  96 }, {   5,   0,  96 },
+	{   6,   0,  96 }, {   7,   0,  96 }, {   8,   0,  96 }, {   8,   0,  96 }, {   9,   0,  96 }, {  10,   0,  96 },
+	{  12,   0,  96 }, {  13,   0,  96 }, {  14,   0,  96 }, {  15,   0,  96 }, {  17,   0,  96 }, {  18,   0,  96 },
+	{  19,   0,  96 }, {  21,   0,  96 }, {  23,   0,  96 }, {  24,   0,  96 }, {  26,   0,  96 }, {  28,   0,  96 },
+	{  30,   0,  96 }, {  32,   0,  96 }, {  34,   0,  96 }, {  36,   0,  96 }, {  39,   0,  96 }, {  41,   0,  96 },
+	{  44,   0,  96 }, {  46,   0,  96 }, {  49,   0,  96 }, {  51,   0,  96 }, {  54,   0,  96 }, {  57,   0,  96 },
+	{  60,   0,  96 }, {  63,   0,  96 }, {  67,   0,  96 }, {  70,   0,  96 }, {  73,   0,  96 }, {  77,   0,  96 },
+	{  80,   0,  96 }, {  84,   0,  96 }, {  88,   0,  96 }, {  92,   0,  96 }, {  96,   0,  96 }, {  96,   0,  92 },
+	{  96,   0,  88 }, {  96,   0,  84 }, {  96,   0,  80 }, {  96,   0,  77 }, {  96,   0,  73 }, {  96,   0,  70 },
+	{  96,   0,  67 }, {  96,   0,  63 }, {  96,   0,  60 }, {  96,   0,  57 }, {  96,   0,  54 }, {  96,   0,  51 },
+	{  96,   0,  49 }, {  96,   0,  46 }, {  96,   0,  44 }, {  96,   0,  41 }, {  96,   0,  39 }, {  96,   0,  36 },
+	{  96,   0,  34 }, {  96,   0,  32 }, {  96,   0,  30 }, {  96,   0,  28 }, {  96,   0,  26 }, {  96,   0,  24 },
+	{  96,   0,  23 }, {  96,   0,  21 }, {  96,   0,  19 }, {  96,   0,  18 }, {  96,   0,  17 }, {  96,   0,  15 },
+	{  96,   0,  14 }, {  96,   0,  13 }, {  96,   0,  12 }, {  96,   0,  10 }, {  96,   0,   9 }, {  96,   0,   8 },
+	{  96,   0,   8 }, {  96,   0,   7 }, {  96,   0,   6 }, {  96,   0,   5 }, {  96,   0,   5 }, {  96,   0,   4 },
+	{  96,   0,   3 }, {  96,   0,   3 }, {  96,   0,   3 }, {  96,   0,   2 }, {  96,   0,   2 }, {  96,   0,   1 },
+	{  96,   0,   1 }, {  96,   0,   1 }, {  96,   0,   1 }, {  96,   0,   0 }, {  96,   0,   0 }, {  96,   0,   0 },
+	{  96,   0,   0 }, {  96,   0,   0 }, {  96,   0,   0 }, {  96,   0,   0 }, {  96,   0,   0 }, {  96,   0,   0 },
+};
@@ -0,0 +1,27 @@
+#ifndef ColorTables_h
+#define ColorTables_h
+
+#include <Arduino.h>
+
+#ifndef PROGMEM
+	// Host build: tables live in ordinary memory.
+	#define PROGMEM
+	#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#endif
+
+// Colour ramps for the time of day and the day of year, generated by tools/colortables.py
+// with gamma correction and brightness baked in. Entries are red, green, blue.
+
+const uint16_t MINUTE_COLOR_STEP = 4;
+const uint16_t MINUTE_COLOR_COUNT = 1440 / MINUTE_COLOR_STEP;
+const uint16_t DAY_COLOR_COUNT = 366;
+
+extern const uint8_t MINUTE_COLORS[MINUTE_COLOR_COUNT][3] PROGMEM;
+extern const uint8_t DAY_COLORS[DAY_COLOR_COUNT][3] PROGMEM;
+
+// Packed pixel colour, as Adafruit_NeoPixel::Color() makes it, but folded at compile time.
+constexpr uint32_t rgbColor(uint8_t r, uint8_t g, uint8_t b) {
+	return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+}
+
+#endif
@@ -0,0 +1,89 @@
+#include "CommandParser.h"
+#include <util/crc16.h>
+
+CommandParser::CommandParser() {
+	index = 0;
+	state = WAIT_START;
+	crc = 0xffff;
+	crcLow = 0;
+	errors = 0;
+}
+
+// Take the next byte from the port. Returns true when it completes a good frame.
+bool CommandParser::feed(uint8_t byte) {
+	switch (state) {
+		case WAIT_START:
+			if (byte == start) {
+				index = 0;
+				crc = 0xffff;
+				state = LENGTH;
+			}
+			return false;
+
+		case LENGTH:
+			if (byte > maxPayload) {
+				errors++;
+				state = WAIT_START;
+				return false;
+			}
+			// Fall through
+
+		case BODY:
+			frame[index++] = byte;
+			crc = _crc16_update(crc, byte);
+			// Length, command, then payload
+			state = index < frame[0] + 2 ? BODY : CRC_LOW;
+			return false;
+
+		case CRC_LOW:
+			crcLow = byte;
+			state = CRC_HIGH;
+			return false;
+
+		case CRC_HIGH:
+			state = WAIT_START;
+			if (crc != (crcLow | (uint16_t)byte << 8)) {
+				errors++;
+				return false;
+			}
+			return true;
+	}
+
+	state = WAIT_START;
+	return false;
+}
+
+uint8_t CommandParser::getCommand() {
+	return frame[1];
+}
+
+const uint8_t *CommandParser::getPayload() {
+	return &frame[2];
+}
+
+uint8_t CommandParser::getLength() {
+	return frame[0];
+}
+
+// Frames dropped for a bad length or CRC.
+uint16_t CommandParser::getErrorCount() {
+	return errors;
+}
+
+// Send a frame.
+void CommandParser::send(Print *out, uint8_t command, const void *payload, uint8_t length) {
+	const uint8_t *p = (const uint8_t *)payload;
+	uint16_t crc = 0xffff;
+
+	out->write(start);
+	out->write(length);
+	crc = _crc16_update(crc, length);
+	out->write(command);
+	crc = _crc16_update(crc, command);
+	for (uint8_t i=0;  i<length;  i++) {
+		out->write(p[i]);
+		crc = _crc16_update(crc, p[i]);
+	}
+	out->write(crc & 0xff);
+	out->write(crc >> 8);
+}
@@ -0,0 +1,50 @@
+#ifndef CommandParser_h
+#define CommandParser_h
+
+#include <Arduino.h>
+
+// Framed binary commands over the serial port, alongside the debug text. The start byte
+// is outside ASCII, so text never looks like the start of a frame, and the CRC rejects
+// the rare false start.
+//
+// Frame layout:
+//	0	start, 0xa5
+//	1	payload length, up to maxPayload
+//	2	command
+//	3	payload
+//	3+n	CRC-16 of bytes 1 - 2+n, little endian
+//
+// Bytes are fed in as they arrive, and the frame is assembled in place. When feed()
+// returns true, the command and payload can be read from the parser's buffer until the
+// next call to feed(). Replies use the same layout, and are sent by send() straight
+// from the caller's data.
+class CommandParser {
+
+	public:
+		static const uint8_t start = 0xa5;
+		static const uint8_t maxPayload = 16;
+
+		CommandParser();
+
+		bool feed(uint8_t byte);
+
+		uint8_t getCommand();
+		const uint8_t *getPayload();
+		uint8_t getLength();
+		uint16_t getErrorCount();
+
+		static void send(Print *out, uint8_t command, const void *payload, uint8_t length);
+
+	private:
+		enum State { WAIT_START, LENGTH, BODY, CRC_LOW, CRC_HIGH };
+
+		// Length, command and payload
+		uint8_t frame[2 + maxPayload];
+		uint8_t index;
+		uint8_t state;
+		uint16_t crc;
+		uint8_t crcLow;
+		uint16_t errors;
+};
+
+#endif
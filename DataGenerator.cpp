@@ -1,11 +1,11 @@
 #include "DataGenerator.h"
 
-DataGenerator::DataGenerator(uint8_t *pattern, size_t length, int noiselevel) {
+DataGenerator::DataGenerator(const uint8_t *pattern, size_t length, int noiselevel) {
 	this->pattern = pattern;
 	this->length = length;
 	this->noiselevel = noiselevel;
 	this->position = 0;
-	setCounts(pattern[0]);
+	setCounts(pgm_read_byte(&pattern[0]));
 }
 
 uint8_t DataGenerator::nextBit() {
@@ -27,7 +27,7 @@ uint8_t DataGenerator::nextBit() {
 	if (position >= length)
 		position = 0;
 
-	setCounts(pattern[position]);
+	setCounts(pgm_read_byte(&pattern[position]));
 
 	// Send leading bit
 	high_count--;
@@ -50,7 +50,7 @@ uint8_t DataGenerator::noisy(uint8_t val) {
 
 void DataGenerator::setCounts(uint8_t symbol) {
 	// Set bit counters.
-	switch (pattern[position]) {
+	switch (symbol) {
 		case ZERO:
 			high_count = 12;
 			low_count = 48;
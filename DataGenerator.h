@@ -4,17 +4,23 @@
 
 #include <Arduino.h>
 
-// Returns synthetic data bits for testing purposes.
+#ifndef PROGMEM
+	// Host build: tables live in ordinary memory.
+	#define PROGMEM
+	#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#endif
+
+// Returns synthetic data bits for testing purposes. The symbol pattern is in flash.
 class DataGenerator {
 
 	public:
-		DataGenerator(uint8_t *pattern, size_t length, int noiselevel);
+		DataGenerator(const uint8_t *pattern, size_t length, int noiselevel);
 
 		uint8_t nextBit();
 
 	private:
 		// Symbol pattern supplied in constructor
-		uint8_t *pattern;
+		const uint8_t *pattern;
 		// Length of pattern
 		size_t length;
 
@@ -0,0 +1,102 @@
+#include "EdgeReceiver.h"
+
+EdgeReceiver::EdgeReceiver() {
+	head = 0;
+	tail = 0;
+	overruns = 0;
+	inPulse = false;
+	falling = false;
+}
+
+// Queue an edge. Invoked from the pin change ISR. When the queue is full, the
+// edge is dropped and counted as an overrun.
+void EdgeReceiver::pushEdge(uint32_t timestamp, bool level) {
+	uint8_t next = (head + 1) & (queueSize - 1);
+	if (next == tail) {
+		overruns++;
+		return;
+	}
+
+	edgeTimes[head] = timestamp;
+	edgeLevels[head] = level;
+	head = next;
+}
+
+// Consume queued edges until a pulse is complete. Returns true and fills in the pulse
+// when one is. A pulse is complete once the signal has stayed low for gapMin after
+// its falling edge, so pass in the current time to finish a pulse with no edge after it.
+bool EdgeReceiver::nextPulse(uint32_t now, Pulse *pulse) {
+
+	while (tail != head) {
+		uint8_t oldSREG = SREG;
+		cli();
+		uint32_t t = edgeTimes[tail];
+		bool level = edgeLevels[tail];
+		SREG = oldSREG;
+
+		if (level) {
+			// Rising edge.
+			if (falling) {
+				if (t - fallTime < gapMin) {
+					// Dropout within the pulse; bridge it.
+					falling = false;
+					tail = (tail + 1) & (queueSize - 1);
+					continue;
+				}
+
+				// The previous pulse is complete. Leave this edge queued to start the next one.
+				finishPulse(pulse);
+				return true;
+			}
+
+			if (!inPulse) {
+				inPulse = true;
+				riseTime = t;
+			}
+		}
+		else {
+			// Falling edge.
+			if (inPulse) {
+				falling = true;
+				fallTime = t;
+			}
+		}
+
+		tail = (tail + 1) & (queueSize - 1);
+	}
+
+	// No more edges. Finish a pulse that has been low for long enough.
+	if (falling  &&  now - fallTime >= gapMin) {
+		finishPulse(pulse);
+		return true;
+	}
+
+	return false;
+}
+
+// Number of edges lost to a full queue.
+uint16_t EdgeReceiver::getOverruns() {
+	uint8_t oldSREG = SREG;
+	cli();
+	uint16_t value = overruns;
+	SREG = oldSREG;
+	return value;
+}
+
+// Measure and classify the pulse under assembly, and reset for the next one.
+void EdgeReceiver::finishPulse(Pulse *pulse) {
+	pulse->start = riseTime;
+	pulse->width = fallTime - riseTime;
+
+	if (pulse->width < widthMin  ||  pulse->width > widthMax)
+		pulse->symbol = 0;
+	else if (pulse->width < widthZeroOne)
+		pulse->symbol = '0';
+	else if (pulse->width < widthOneMarker)
+		pulse->symbol = '1';
+	else
+		pulse->symbol = 'M';
+
+	inPulse = false;
+	falling = false;
+}
@@ -0,0 +1,56 @@
+#ifndef EdgeReceiver_h
+#define EdgeReceiver_h
+
+#include <Arduino.h>
+
+// A pulse from the receiver: the time of its rising edge and its width, in Timer1
+// counts (0.5us), and the symbol its width represents.
+struct Pulse {
+	uint32_t start;
+	uint32_t width;
+	char symbol;	// '0', '1', 'M', or 0 if the width doesn't match any symbol
+};
+
+// Event-driven receiver front end. The pin change ISR timestamps each edge of the
+// receiver output and queues it with pushEdge(); the main loop pairs the edges into
+// pulses with nextPulse(), and classifies them by width.
+//
+// Short dropouts within a pulse (under gapMin) are bridged, so a noisy pulse
+// is still measured as one pulse.
+class EdgeReceiver {
+
+	public:
+		// Queue length; must be a power of 2.
+		static const uint8_t queueSize = 8;
+
+		// Width limits, in Timer1 counts. Nominal widths are 200ms (ZERO),
+		// 500ms (ONE) and 800ms (MARKER).
+		static const uint32_t widthMin = 100000;		// 50ms
+		static const uint32_t widthZeroOne = 700000;	// 350ms
+		static const uint32_t widthOneMarker = 1300000;	// 650ms
+		static const uint32_t widthMax = 1800000;		// 900ms
+		static const uint32_t gapMin = 80000;			// 40ms
+
+		EdgeReceiver();
+
+		void pushEdge(uint32_t timestamp, bool level);
+		bool nextPulse(uint32_t now, Pulse *pulse);
+		uint16_t getOverruns();
+
+	private:
+		volatile uint32_t edgeTimes[queueSize];
+		volatile bool edgeLevels[queueSize];
+		volatile uint8_t head;
+		volatile uint8_t tail;
+		volatile uint16_t overruns;
+
+		// Pulse assembly state
+		bool inPulse;
+		bool falling;
+		uint32_t riseTime;
+		uint32_t fallTime;
+
+		void finishPulse(Pulse *pulse);
+};
+
+#endif
@@ -0,0 +1,107 @@
+#include "EepromWriter.h"
+#ifndef __AVR__
+#include <EEPROM.h>
+#endif
+
+EepromWriter::EepromWriter() {
+	head = 0;
+	count = 0;
+	offset = 0;
+	bytesWritten = 0;
+}
+
+// Queue a write. Returns false, queueing nothing, when the queue is full.
+bool EepromWriter::write(uint16_t address, const void *data, uint16_t length,
+		Callback done, void *context) {
+	uint8_t oldSREG = SREG;
+	cli();
+
+	if (count >= queueSize) {
+		SREG = oldSREG;
+		return false;
+	}
+
+	uint8_t tail = head + count;
+	if (tail >= queueSize)
+		tail -= queueSize;
+
+	Job *job = &jobs[tail];
+	job->address = address;
+	job->data = (const uint8_t *)data;
+	job->length = length;
+	job->done = done;
+	job->context = context;
+	count++;
+
+#ifdef __AVR__
+	// The interrupt fires whenever the EEPROM is ready, so this starts the queue.
+	EECR |= _BV(EERIE);
+#else
+	// Host build: no interrupt, so write straight away.
+	while (count > 0)
+		service();
+#endif
+
+	SREG = oldSREG;
+	return true;
+}
+
+bool EepromWriter::isIdle() {
+	return count == 0;
+}
+
+// Wait for all queued writes to complete. Interrupts must be enabled.
+void EepromWriter::flush() {
+	while (count > 0)
+		;
+}
+
+// Start programming the next byte that needs it, completing jobs on the way. Call from
+// the EE_READY interrupt.
+void EepromWriter::service() {
+	while (count > 0) {
+		Job *job = &jobs[head];
+
+		while (offset < job->length) {
+			uint16_t address = job->address + offset;
+			uint8_t value = job->data[offset];
+			offset++;
+
+#ifdef __AVR__
+			EEAR = address;
+			EECR |= _BV(EERE);
+			if (EEDR == value)
+				continue;
+
+			// Erase and write. EEPE must be set within four cycles of EEMPE.
+			EEDR = value;
+			EECR = _BV(EERIE) | _BV(EEMPE);
+			EECR |= _BV(EEPE);
+			bytesWritten++;
+			return;
+#else
+			if (EEPROM.read(address) != value) {
+				EEPROM.update(address, value);
+				bytesWritten++;
+			}
+#endif
+		}
+
+		offset = 0;
+		if (++head >= queueSize)
+			head = 0;
+		count--;
+
+		if (job->done)
+			job->done(job->context);
+	}
+
+#ifdef __AVR__
+	EECR &= ~_BV(EERIE);
+#endif
+}
+
+// Bytes actually programmed, as opposed to skipped because they were unchanged.
+uint16_t EepromWriter::getBytesWritten() {
+	return bytesWritten;
+}
@@ -0,0 +1,52 @@
+#ifndef EepromWriter_h
+#define EepromWriter_h
+
+#include <Arduino.h>
+
+// Writes to EEPROM in the background. Each write is queued as a job, and the EE_READY
+// interrupt programs one byte at a time, skipping bytes that already hold their value.
+// A byte takes about 3.3ms, during which the CPU is free.
+//
+// The data of a job is read as it is written, so it must stay in place until the job
+// completes. The job's callback, if any, runs in the interrupt when it does.
+//
+// Don't read the EEPROM while jobs are pending: reads share the address register with
+// the interrupt. Call flush() first.
+class EepromWriter {
+
+	public:
+		typedef void (*Callback)(void *context);
+
+		static const uint8_t queueSize = 4;
+
+		EepromWriter();
+
+		bool write(uint16_t address, const void *data, uint16_t length,
+				Callback done, void *context);
+		bool isIdle();
+		void flush();
+
+		void service();
+
+		uint16_t getBytesWritten();
+
+	private:
+		struct Job {
+			uint16_t address;
+			const uint8_t *data;
+			uint16_t length;
+			Callback done;
+			void *context;
+		};
+
+		Job jobs[queueSize];
+		volatile uint8_t head;
+		volatile uint8_t count;
+
+		// Bytes of the head job already handled
+		uint16_t offset;
+
+		uint16_t bytesWritten;
+};
+
+#endif
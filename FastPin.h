@@ -0,0 +1,87 @@
+#ifndef FastPin_h
+#define FastPin_h
+
+#include <Arduino.h>
+
+// Register access for each I/O port of the ATmega328: 0 is port D, 1 is port B,
+// and 2 is port C.
+template <uint8_t port> struct FastPinPort;
+
+#ifdef __AVR__
+template <> struct FastPinPort<0> {
+	static inline volatile uint8_t &out() __attribute__((always_inline)) { return PORTD; }
+	static inline volatile uint8_t &in() __attribute__((always_inline)) { return PIND; }
+	static inline volatile uint8_t &dir() __attribute__((always_inline)) { return DDRD; }
+};
+
+template <> struct FastPinPort<1> {
+	static inline volatile uint8_t &out() __attribute__((always_inline)) { return PORTB; }
+	static inline volatile uint8_t &in() __attribute__((always_inline)) { return PINB; }
+	static inline volatile uint8_t &dir() __attribute__((always_inline)) { return DDRB; }
+};
+
+template <> struct FastPinPort<2> {
+	static inline volatile uint8_t &out() __attribute__((always_inline)) { return PORTC; }
+	static inline volatile uint8_t &in() __attribute__((always_inline)) { return PINC; }
+	static inline volatile uint8_t &dir() __attribute__((always_inline)) { return DDRC; }
+};
+#else
+// Host build (simulator): each port is a set of plain variables. The simulator drives
+// inputs by writing in(), and observes outputs by reading out().
+template <uint8_t port> struct FastPinPort {
+	static inline volatile uint8_t &out() { static volatile uint8_t reg = 0; return reg; }
+	static inline volatile uint8_t &in() { static volatile uint8_t reg = 0; return reg; }
+	static inline volatile uint8_t &dir() { static volatile uint8_t reg = 0; return reg; }
+};
+#endif
+
+// A digital pin, using Arduino Uno numbering, with its port and bit resolved at compile
+// time: pins 0-7 are port D, 8-13 port B, and 14-19 port C. On the AVR, high(), low()
+// and toggle() each compile to a single sbi / cbi instruction, and a test of read()
+// to sbic / sbis.
+template <uint8_t pin>
+struct FastPin {
+	static_assert(pin < 20, "FastPin only maps Arduino pins 0 to 19");
+
+	typedef FastPinPort<(pin < 8) ? 0 : (pin < 14) ? 1 : 2> Port;
+	static const uint8_t mask = 1 << ((pin < 8) ? pin : (pin < 14) ? pin-8 : pin-14);
+
+	static inline void high() __attribute__((always_inline)) {
+		Port::out() |= mask;
+	}
+
+	static inline void low() __attribute__((always_inline)) {
+		Port::out() &= (uint8_t)~mask;
+	}
+
+	static inline void write(bool value) __attribute__((always_inline)) {
+		if (value)
+			high();
+		else
+			low();
+	}
+
+	// Writing a 1 to the PINx register toggles the output latch. The host has no such
+	// register, so toggles the output directly.
+	static inline void toggle() __attribute__((always_inline)) {
+#ifdef __AVR__
+		Port::in() = mask;
+#else
+		Port::out() ^= mask;
+#endif
+	}
+
+	static inline bool read() __attribute__((always_inline)) {
+		return (Port::in() & mask) != 0;
+	}
+
+	static inline void output() __attribute__((always_inline)) {
+		Port::dir() |= mask;
+	}
+
+	static inline void input() __attribute__((always_inline)) {
+		Port::dir() &= (uint8_t)~mask;
+	}
+};
+
+#endif
@@ -0,0 +1,148 @@
+#include "FrequencyEstimator.h"
+
+FrequencyEstimator::FrequencyEstimator(uint32_t nominalCountsPerSecond) {
+	nominal = nominalCountsPerSecond;
+	reset();
+}
+
+// Discard all measurements.
+void FrequencyEstimator::reset() {
+	started = false;
+	seconds = 0;
+	rejected = 0;
+	retainedPpb = 0;
+	retainedSeconds = 0;
+	offsetPpb = 0;
+	n = 0;
+}
+
+// Add the timestamp (in timer counts) of a received second edge. Returns true
+// if the edge was accepted.
+bool FrequencyEstimator::addEdge(uint32_t timestamp) {
+
+	if (!started) {
+		restart(timestamp);
+		return true;
+	}
+
+	// Whole seconds since the last accepted edge, at the current estimate.
+	uint32_t diff = timestamp - lastEdge;
+	uint32_t period = nominal + (int32_t)(((int64_t)offsetPpb * nominal) / 1000000000L);
+	uint32_t elapsed = (diff + period / 2) / period;
+
+	if (elapsed > maxGapSeconds) {
+		restart(timestamp);
+		return true;
+	}
+
+	int32_t newPhase = phase + (int32_t)(diff - elapsed * nominal);
+	int32_t predicted = phase + (int32_t)(((int64_t)offsetPpb * nominal / 1000000000L) * elapsed);
+	int32_t residual = newPhase - predicted;
+
+	if (elapsed == 0  ||  residual > tolerance  ||  residual < -tolerance) {
+		rejected++;
+		if (++consecutiveRejects >= maxRejects)
+			restart(timestamp);
+		return false;
+	}
+
+	consecutiveRejects = 0;
+	lastEdge = timestamp;
+	seconds += elapsed;
+	phase = newPhase;
+
+	n++;
+	sumS += seconds;
+	sumP += phase;
+	sumSS += (int64_t)seconds * seconds;
+	sumSP += (int64_t)seconds * phase;
+
+	// Once the baseline is long enough, publish its fit weighted against the estimate
+	// retained from earlier baselines.
+	if (seconds >= minFitSeconds) {
+		uint32_t total = retainedSeconds + seconds;
+		offsetPpb = (int32_t)(((int64_t)retainedPpb * retainedSeconds + (int64_t)fitOffsetPpb() * seconds) / total);
+	}
+
+	if (seconds >= maxBaselineSeconds)
+		restart(timestamp);
+
+	return true;
+}
+
+// Length of the current baseline, in seconds.
+uint32_t FrequencyEstimator::getBaselineSeconds() {
+	return started ? seconds : 0;
+}
+
+// Length of the baselines behind the published estimate, in seconds: those retained
+// from before the last restart, plus the current one once it contributes.
+uint32_t FrequencyEstimator::getEstimateSeconds() {
+	uint32_t current = (started  &&  seconds >= minFitSeconds) ? seconds : 0;
+	return retainedSeconds + current;
+}
+
+// Number of edges accepted into the current baseline.
+uint16_t FrequencyEstimator::getPoints() {
+	return n;
+}
+
+// Total number of edges rejected as outliers.
+uint16_t FrequencyEstimator::getRejected() {
+	return rejected;
+}
+
+// Frequency offset of the local crystal, in parts per billion. Positive when the
+// crystal runs fast, i.e. more than the nominal counts in one received second.
+int32_t FrequencyEstimator::getOffsetPpb() {
+	return offsetPpb;
+}
+
+// Timer period for the given tick rate at the measured frequency, scaled by the
+// denominator of the fractional period.
+uint32_t FrequencyEstimator::getScaledTickCounts(uint8_t ticksPerSecond, uint8_t denominator) {
+	int64_t divisor = (int64_t)ticksPerSecond * 1000000000L;
+	int64_t scaled = (int64_t)nominal * denominator * (1000000000L + offsetPpb);
+	return (uint32_t)((scaled + divisor / 2) / divisor);
+}
+
+// Slope of the least-squares line through the points, in ppb of the nominal rate.
+int32_t FrequencyEstimator::fitOffsetPpb() {
+	int64_t num = (int64_t)n * sumSP - sumS * sumP;
+	int64_t den = (int64_t)n * sumSS - sumS * sumS;
+	if (den <= 0)
+		return offsetPpb;
+
+	// Slope is num/den counts per second; one count per second is 1e9/nominal ppb.
+	// Scale whichever of num and den keeps the arithmetic within 64 bits.
+	int64_t ppbPerCount = 1000000000L / nominal;
+	int64_t limit = 0x7fffffffffffffffLL / ppbPerCount;
+	if (num < limit  &&  num > -limit)
+		return (int32_t)(num * ppbPerCount / den);
+
+	return (int32_t)(num / (den / ppbPerCount));
+}
+
+// Start a new baseline at the given edge. The published estimate is retained, to predict
+// edges and to weight against the new fit. Its weight is capped at maxBaselineSeconds so
+// that the estimate still follows a crystal that drifts with temperature or age.
+void FrequencyEstimator::restart(uint32_t timestamp) {
+	if (started  &&  seconds >= minFitSeconds) {
+		retainedPpb = offsetPpb;
+		retainedSeconds += seconds;
+		if (retainedSeconds > maxBaselineSeconds)
+			retainedSeconds = maxBaselineSeconds;
+	}
+
+	started = true;
+	lastEdge = timestamp;
+	seconds = 0;
+	phase = 0;
+	consecutiveRejects = 0;
+
+	n = 1;
+	sumS = 0;
+	sumP = 0;
+	sumSS = 0;
+	sumSP = 0;
+}
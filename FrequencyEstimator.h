@@ -0,0 +1,71 @@
+#ifndef FrequencyEstimator_h
+#define FrequencyEstimator_h
+
+#include <Arduino.h>
+
+// Measures the frequency of the local crystal against the received second edges,
+// over baselines of minutes to hours. Each accepted edge contributes a point
+// (elapsed seconds, accumulated phase), and a least-squares line through the points
+// gives the frequency offset, so edge jitter averages out as the baseline grows.
+//
+// Edges whose phase is too far from the predicted value are rejected as outliers.
+// A run of rejections, a gap longer than maxGapSeconds, or a baseline reaching
+// maxBaselineSeconds starts a new baseline. The estimate so far is retained across
+// the restart, and the new fit is weighted against it by baseline length, so the
+// published estimate never falls back to a short baseline.
+class FrequencyEstimator {
+
+	public:
+		// Edge phase must be within this many counts of the prediction.
+		static const int32_t tolerance = 40000;				// 20ms at 2MHz
+		// Longest gap between accepted edges before starting over.
+		static const uint16_t maxGapSeconds = 600;
+		// Consecutive rejections before starting over.
+		static const uint8_t maxRejects = 20;
+		// Baseline needed before the fit contributes to the estimate.
+		static const uint16_t minFitSeconds = 120;
+		// Baseline length at which the sums are restarted, to keep them within range.
+		static const uint32_t maxBaselineSeconds = 10800;	// 3 hours
+
+		FrequencyEstimator(uint32_t nominalCountsPerSecond);
+
+		void reset();
+		bool addEdge(uint32_t timestamp);
+
+		uint32_t getBaselineSeconds();
+		uint32_t getEstimateSeconds();
+		uint16_t getPoints();
+		uint16_t getRejected();
+		int32_t getOffsetPpb();
+		uint32_t getScaledTickCounts(uint8_t ticksPerSecond, uint8_t denominator);
+
+	private:
+		uint32_t nominal;
+
+		bool started;
+		uint32_t lastEdge;		// Timestamp of the last accepted edge
+		uint32_t seconds;		// Seconds from the first accepted edge to the last
+		int32_t phase;			// Accumulated phase at the last edge: elapsed counts minus seconds * nominal
+		uint16_t consecutiveRejects;
+		uint16_t rejected;
+
+		// Least-squares sums over the accepted points (s, phase)
+		uint16_t n;
+		int64_t sumS;
+		int64_t sumP;
+		int64_t sumSS;
+		int64_t sumSP;
+
+		// Estimate from the previous baselines, and their length, kept while a new one
+		// builds up
+		int32_t retainedPpb;
+		uint32_t retainedSeconds;
+
+		// Published estimate: the retained one, weighted with the current fit
+		int32_t offsetPpb;
+
+		int32_t fitOffsetPpb();
+		void restart(uint32_t timestamp);
+};
+
+#endif
@@ -0,0 +1,131 @@
+#include "Journal.h"
+#include <EEPROM.h>
+#include <util/crc16.h>
+
+Journal::Journal(uint16_t s, uint16_t size, EepromWriter *w) {
+	start = s;
+	slots = size / recordSize;
+	writer = w;
+	writing = false;
+	newestSlot = noSlot;
+	newestSequence = 0;
+}
+
+// Find the newest valid record. Reads only the sequence numbers, and checks the CRC of
+// a record when it would be the newest so far. Returns false when there is none.
+bool Journal::scan() {
+	newestSlot = noSlot;
+
+	for (uint8_t slot=0;  slot<slots;  slot++) {
+		uint16_t sequence = readWord(address(slot));
+		if (newestSlot != noSlot  &&  (int16_t)(sequence - newestSequence) <= 0)
+			continue;
+
+		if (valid(slot)) {
+			newestSlot = slot;
+			newestSequence = sequence;
+		}
+	}
+
+	return newestSlot != noSlot;
+}
+
+bool Journal::hasRecord() {
+	return newestSlot != noSlot;
+}
+
+// Copy out the newest record. Returns the payload length, or 0 when there is no record.
+// A payload longer than maxLength is cut short.
+uint8_t Journal::read(uint8_t *version, void *payload, uint8_t maxLength) {
+	if (newestSlot == noSlot)
+		return 0;
+
+	uint16_t a = address(newestSlot);
+	*version = EEPROM.read(a + 2);
+	uint8_t length = EEPROM.read(a + 3);
+	if (length > maxLength)
+		length = maxLength;
+
+	uint8_t *p = (uint8_t *)payload;
+	for (uint8_t i=0;  i<length;  i++)
+		p[i] = EEPROM.read(a + 4 + i);
+
+	return length;
+}
+
+// Queue a new record after the newest one. Returns false, saving nothing, while the
+// last record is still being written or the writer's queue is full.
+bool Journal::append(uint8_t version, const void *payload, uint8_t length) {
+	if (writing)
+		return false;
+
+	if (length > payloadSize)
+		length = payloadSize;
+
+	uint8_t slot = (newestSlot == noSlot  ||  newestSlot + 1 >= slots) ? 0 : newestSlot + 1;
+	uint16_t sequence = newestSlot == noSlot ? 0 : newestSequence + 1;
+
+	record[0] = sequence & 0xff;
+	record[1] = sequence >> 8;
+	record[2] = version;
+	record[3] = length;
+
+	const uint8_t *p = (const uint8_t *)payload;
+	for (uint8_t i=0;  i<payloadSize;  i++)
+		record[4 + i] = i < length ? p[i] : 0;
+
+	uint16_t crc = 0xffff;
+	for (uint8_t i=0;  i<recordSize-2;  i++)
+		crc = _crc16_update(crc, record[i]);
+	record[recordSize-2] = crc & 0xff;
+	record[recordSize-1] = crc >> 8;
+
+	writing = true;
+	if (!writer->write(address(slot), record, recordSize, written, this)) {
+		writing = false;
+		return false;
+	}
+
+	// The CRC goes out last, so the record only becomes valid once it is complete.
+	newestSlot = slot;
+	newestSequence = sequence;
+	return true;
+}
+
+bool Journal::isWriting() {
+	return writing;
+}
+
+// Completion callback from the writer.
+void Journal::written(void *context) {
+	((Journal *)context)->writing = false;
+}
+
+uint16_t Journal::getSequence() {
+	return newestSequence;
+}
+
+uint8_t Journal::getSlot() {
+	return newestSlot;
+}
+
+uint16_t Journal::address(uint8_t slot) {
+	return start + (uint16_t)slot * recordSize;
+}
+
+bool Journal::valid(uint8_t slot) {
+	uint16_t a = address(slot);
+
+	if (EEPROM.read(a + 3) > payloadSize)
+		return false;
+
+	uint16_t crc = 0xffff;
+	for (uint8_t i=0;  i<recordSize-2;  i++)
+		crc = _crc16_update(crc, EEPROM.read(a + i));
+
+	return crc == readWord(a + recordSize - 2);
+}
+
+uint16_t Journal::readWord(uint16_t a) {
+	return EEPROM.read(a) | (uint16_t)EEPROM.read(a + 1) << 8;
+}
@@ -0,0 +1,61 @@
+#ifndef Journal_h
+#define Journal_h
+
+#include <Arduino.h>
+#include "EepromWriter.h"
+
+// A log of fixed size records in an EEPROM region. Each save goes to the slot after the
+// newest record, so writes are spread over the whole region, and a save that is cut off
+// leaves the previous record intact.
+//
+// Record layout, 32 bytes:
+//	0	sequence number, 16 bits, little endian
+//	2	payload version, chosen by the caller
+//	3	payload length
+//	4	payload, up to payloadSize bytes
+//	30	CRC-16 of bytes 0 - 29, little endian
+//
+// Sequence numbers are compared with wraparound, which is safe as long as the journal
+// holds fewer than 32768 records.
+//
+// Records are written in the background by an EepromWriter; scan() and read() must
+// not run while it has writes pending.
+class Journal {
+
+	public:
+		static const uint8_t recordSize = 32;
+		static const uint8_t payloadSize = recordSize - 6;
+
+		Journal(uint16_t start, uint16_t size, EepromWriter *writer);
+
+		bool scan();
+		bool hasRecord();
+		uint8_t read(uint8_t *version, void *payload, uint8_t maxLength);
+		bool append(uint8_t version, const void *payload, uint8_t length);
+		bool isWriting();
+
+		uint16_t getSequence();
+		uint8_t getSlot();
+
+	private:
+		uint16_t start;
+		uint8_t slots;
+		EepromWriter *writer;
+
+		// Record being written, and whether the writer still has it
+		uint8_t record[recordSize];
+		volatile bool writing;
+
+		// Slot of the newest valid record, or noSlot
+		static const uint8_t noSlot = 0xff;
+		uint8_t newestSlot;
+		uint16_t newestSequence;
+
+		uint16_t address(uint8_t slot);
+		bool valid(uint8_t slot);
+		uint16_t readWord(uint16_t address);
+
+		static void written(void *context);
+};
+
+#endif
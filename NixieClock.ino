@@ -1,11 +1,27 @@
 #include <SPI.h>
 #include <EEPROM.h>
+#include <avr/wdt.h>
+#include <util/crc16.h>
 #include "DataGenerator.h"
 #include "ScoreBoard.h"
-#include <Adafruit_NeoPixel.h>
-#ifdef __AVR__
-  #include <avr/power.h>
-#endif
+#include "WwvbDecoder.h"
+#include "Scheduler.h"
+#include "FastPin.h"
+#include "EdgeReceiver.h"
+#include "FrequencyEstimator.h"
+#include "NixieSegments.h"
+#include "Calendar.h"
+#include "CathodeCare.h"
+#include "NixieEngine.h"
+#include "ColorTables.h"
+#include "RingAnimation.h"
+#include "Brightness.h"
+#include "PixelChain.h"
+#include "EepromWriter.h"
+#include "Journal.h"
+#include "CommandParser.h"
+#include "Profiler.h"
+#include "StackMonitor.h"
 
 
 // Pin map
@@ -95,15 +111,28 @@
 // and score a point for each frame symbol seen in a frame slot, and a point for each non-frame
 // symbol seen in a non-frame slot. When the maximum score of 60 is received, we consider that
 // a match, and decode the current time of day, and update the displayed time.
+//
+// The correlator, the peak finding and the symbol stream are in WwvbDecoder, which also
+// builds on a host: tools/replay runs recorded and synthetic samples through it.
 // 
 // Timer1 interrupts at 60Hz (one tick), creating the heartbeat. An ISR is responsible
 // for sampling the input signal and shifting it into the input shift register, scoring (x3),
 // and shifting the symbol scores into their shift registers. 
 //
-// Timer2 is configured for PWM, at 244Hz, to control tube brightness.
+// Timer2 is configured for PWM, at 2kHz, to control tube brightness. Its compare interrupt
+// steps the nixie engine through 8 slots, so a frame can be latched for each slot of a 250Hz
+// period. That gives each tube its own duty cycle, and crossfades digits at each second.
+//
+// Nixie frames are shifted out to the tube drivers by the SPI transfer-complete interrupt,
+// which raises RCK to latch the frame once the last byte is out.
+//
+// Alongside the sampler, a pin change interrupt timestamps each edge of the receiver output
+// from Timer1, to 0.5us. The edges are assembled into pulses, whose widths classify them
+// as symbols, and whose rising edges give the phase of the received second to far better
+// than one tick.
 
 // Heartbeat indicator
-const int PIN_HEARTBEAT = 2; // PORTD bit 2
+const int PIN_HEARTBEAT = 2;
 
 // PWM for tube brightness
 const int PIN_PWM = 3;
@@ -115,33 +144,103 @@ const int PIN_HV = 5;
 const int PIN_PIXEL = 6;
 
 // SYMTRIK input pin
-const int PIN_WWVB = 7; // PORTD bit 7
+const int PIN_WWVB = 7;
 
 // Nixie tube register clock (RCK)
 const int PIN_RCK = 8;
 
 // Reflect WWVB input pin
-const int PIN_ECHO = 9; // PORTB bit 1
+const int PIN_ECHO = 9;
 
 // SPI pins for Nixie tube data and SRCK
 const int PIN_MOSI = 11;
 const int PIN_MISO = 12; // Unused
 const int PIN_SCK = 13;
 
+// SPI clock for the nixie shift registers. The hardware divides F_CPU by a power of two,
+// so this is rounded down to one of 8, 4, 2, 1MHz... Keep it at or below the maximum
+// SRCK rate of the shift registers.
+const uint32_t NIXIE_SPI_CLOCK = 4000000;
+
 const int PIN_ROT_PB = 14;
 const int PIN_ROT_A = 15;
 const int PIN_ROT_B = 16;
 
+// Pins used in the hot paths (ISRs), with port and bit resolved at compile time.
+typedef FastPin<PIN_HEARTBEAT> HeartbeatPin;
+typedef FastPin<PIN_WWVB> WwvbPin;
+typedef FastPin<PIN_RCK> RckPin;
+typedef FastPin<PIN_ECHO> EchoPin;
+typedef FastPin<PIN_PIXEL> PixelPin;
+
 
 // Version number for parameters structure.
-const int parametersVersion = 2;
+const int parametersVersion = 5;
 
 // Parameters for clock that get saved in EEPROM. Version number helps with sanity checking.
 typedef struct {
 	uint8_t version;
 	uint32_t scaledCounts;
+
+	// Version 3: time of day (UTC) when saved, for a warm start. See SAVED_TIME_*.
+	uint8_t timeFlags;
+	uint8_t year;		// Since 2000
+	uint16_t day;
+	uint8_t hours;
+	uint8_t minutes;
+	uint8_t seconds;
+
+	// Version 4: settings made over the serial link. See SAVED_SETTING_*.
+	int8_t tzOffsetHours;
+	int8_t tzOffsetMinutes;
+	uint8_t settingFlags;
+	uint8_t scoreThreshold;
+	uint8_t detectedSymbolThreshold;
+	uint8_t missedSymbolThreshold;
+
+	// Version 5: duty cycle of the seconds tubes.
+	uint8_t secondsDuty;
 } PersistentParameters;
 
+// Bits of PersistentParameters.timeFlags.
+const uint8_t SAVED_TIME_VALID = 0x01;
+const uint8_t SAVED_TIME_LEAP_YEAR = 0x02;
+const uint8_t SAVED_TIME_DST = 0x04;
+const uint8_t SAVED_TIME_POWER_LOSS = 0x08;		// Saved as the supply went down
+
+// Bits of PersistentParameters.settingFlags.
+const uint8_t SAVED_SETTING_OBSERVE_DST = 0x01;
+const uint8_t SAVED_SETTING_OVERRIDE = 0x02;
+
+// Length of the parameters before versions 3, 4 and 5.
+const uint8_t PARAMETERS_V2_LENGTH = 5;
+const uint8_t PARAMETERS_V3_LENGTH = 12;
+const uint8_t PARAMETERS_V4_LENGTH = 18;
+
+// A warm start takes the first frame's hours and minutes without the date, so long
+// as they are no more than this long after the saved time.
+const uint16_t WARM_START_WINDOW_MINUTES = 12 * 60;
+
+// Least mean symbol margin over the early frame check (see WwvbDecoder::earlyFrameStart). With only 21 symbols to check
+// instead of a whole frame, the soft decisions make up for the weaker structure check.
+// Clean reception gives margins near 18, the samples by which the nearest patterns differ.
+const uint8_t EARLY_FRAME_MIN_MARGIN = 6;
+
+// Parameters are saved to a journal in EEPROM, which spreads the writes over its region.
+// Before the journal, they were saved at address 0, which is now the journal's first slot.
+const uint16_t JOURNAL_ADDRESS = 0;
+const uint16_t JOURNAL_SIZE = 896;
+
+// EEPROM writes go through the writer's queue, and complete in the background.
+EepromWriter eepromWriter;
+Journal journal(JOURNAL_ADDRESS, JOURNAL_SIZE, &eepromWriter);
+
+// Ticks between parameter saves, while there are unsaved changes: 15 minutes
+const uint32_t PARAMETER_SAVE_TICKS = 54000;
+
+// EEPROM address of the cathode usage counts.
+const int CATHODE_CARE_ADDRESS = 896;
+
 // Set true to prevent loading stored parameters at startup, and storing adjusted parameters.
 bool overrideSavedParameters = false;
 
@@ -160,9 +259,80 @@ const uint8_t tick_frac_denominator = 64;  // Denominator of fraction (no. of lo
 // interrupt processing; reset in main loop after saving parameters.
 volatile bool unsaved_parameters = false;
 
+// Supply voltage, measured against the 1.1V bandgap once a tick. When it sags below
+// VCC_LOW_MILLIVOLTS, anything unsaved is written to EEPROM while there is still time.
+// The ADC reads 1024 * 1.1V / Vcc, so a low supply gives a high reading.
+const uint16_t VCC_LOW_MILLIVOLTS = 4500;
+const uint16_t VCC_RECOVERED_MILLIVOLTS = 4700;
+const uint16_t VCC_LOW_READING = 1126400UL / VCC_LOW_MILLIVOLTS;
+const uint16_t VCC_RECOVERED_READING = 1126400UL / VCC_RECOVERED_MILLIVOLTS;
+volatile uint16_t vcc_reading = 0;
+bool vcc_low = false;
+
+// Set true by measureVcc() when the supply goes low; monitored and reset by main loop.
+volatile bool vcc_low_flag = false;
+
+// Set by taskVccLow() while the HV supply and pixels are off to save power, and while it
+// still has saves to queue. The pixel task restores the load once the supply recovers.
+bool vcc_shed = false;
+bool vcc_parametersPending = false;
+bool vcc_cathodeCarePending = false;
+
 // Set true by adjustTickInterval; monitored and reset by main loop.
 volatile bool tick_interval_changed = false;
 
+// Time and discipline state, carried over a watchdog or external reset in SRAM that the
+// C runtime leaves alone (.noinit). The tick ISR refreshes it once a tick; the CRC tells
+// a snapshot from what SRAM holds at power up, or one torn by the reset.
+typedef struct {
+	uint16_t tickIntervalCycles;
+	uint8_t tickFracNumerator;
+	uint8_t mode;
+	uint8_t ticks;
+	uint8_t seconds;
+	uint8_t minutes;
+	uint8_t hours;
+	uint16_t day;
+	uint16_t year;
+	uint8_t flags;		// See RECOVERY_*
+	uint16_t crc;
+} RecoveryState;
+
+// Bits of RecoveryState.flags.
+const uint8_t RECOVERY_FIX = 0x01;
+const uint8_t RECOVERY_ESTIMATED = 0x02;
+const uint8_t RECOVERY_LEAP_YEAR = 0x04;
+const uint8_t RECOVERY_DST = 0x08;
+
+RecoveryState recovery __attribute__((section(".noinit")));
+
+// Set at the end of setup(), once anything worth recovering has been taken from the snapshot.
+volatile bool recovery_armed = false;
+
+// MCUSR at reset, saved by saveResetCause() before the C runtime starts.
+uint8_t reset_cause __attribute__((section(".noinit")));
+
+// Run times of the tick ISR and its main parts, and of the tasks run by the main loop.
+enum {
+	PROFILE_TICK_LATENCY,		// Compare match to the start of the tick ISR
+	PROFILE_TICK,				// Whole tick ISR
+	PROFILE_CORRELATE,			// Pattern scoring
+	PROFILE_DECODE,				// decodeSymbols()
+	PROFILE_TASK,				// One task run by loop()
+	PROFILE_SEGMENTS
+};
+Profiler::Segment profileSegments[PROFILE_SEGMENTS];
+Profiler profiler(profileSegments, PROFILE_SEGMENTS);
+
+// Set true to hold the heartbeat pin high while a task runs, as well as during the tick
+// ISR, so its duty cycle shows the CPU load.
+const bool heartbeatShowsLoad = false;
+volatile bool loop_busy = false;
+
+// The watchdog is fed by the tick ISR, but only when the main loop has been round since
+// the last feed, so a hang in either one resets the clock.
+volatile bool loop_progress = false;
+
 // Offset of pixel segments
 // First pixel is the rotary encoder; next 60 pixels are the ring;
 // the final 10 are the on-board backlight pixels
@@ -171,74 +341,153 @@ const int PIXEL_OFFSET_RING = 1;		// 60 pixels
 const int PIXEL_OFFSET_BACKLIGHT = 61;	// 10 pixels
 const int PIXEL_COUNT = 71;
 
-Adafruit_NeoPixel pixels = Adafruit_NeoPixel(PIXEL_COUNT, PIN_PIXEL, NEO_GRB + NEO_KHZ800);
+// Pixels are sent in segments: the encoder, the ring in eighths, and the backlight in
+// halves. Each entry is the pixel after the end of a segment. At 30us a pixel, no segment
+// holds interrupts off for more than 240us.
+const uint8_t PIXEL_SEGMENT_ENDS[] = { 1, 9, 16, 24, 31, 39, 46, 54, 61, 66, 71 };
+
+uint8_t pixelBuffer[PIXEL_COUNT * 3];
+PixelChain pixels(pixelBuffer, PIXEL_COUNT, &PixelPin::Port::out(), PixelPin::mask,
+		PIXEL_SEGMENT_ENDS, sizeof(PIXEL_SEGMENT_ENDS));
+
+// Animations drawn over the ring
+RingAnimation ringAnimation;
+
+// Ring colors, as composed by ringIndex(). Animation palette indices follow RING_ANIMATION.
+enum {
+	RING_OFF,
+	RING_SAMPLE_ONE,
+	RING_SAMPLE_ZERO,
+	RING_SAMPLE_CURSOR,
+	RING_SYMBOL_ZERO,
+	RING_SYMBOL_ONE,
+	RING_SYMBOL_MARKER,
+	RING_SYNC,
+	RING_HAND_HOUR,
+	RING_HAND_MINUTE,
+	RING_METER_ZERO,			// Each meter color is followed by its peak color
+	RING_METER_ZERO_PEAK,
+	RING_METER_ONE,
+	RING_METER_ONE_PEAK,
+	RING_METER_MARKER,
+	RING_METER_MARKER_PEAK,
+	RING_ANIMATION
+};
+
+// Ring mode for the correlator meter, alongside MODE_SEEK and MODE_SYNC
+const uint8_t RING_MODE_METER = 0x80;
+
+// Correlator meter: score of random input, at the bottom of the scale, and the length
+// of the bar for the current score.
+const uint8_t METER_FLOOR = 40;
+const uint8_t METER_BAR = 20 - ScoreBoard::size;
+
+// The ring shows the correlator meter, for aiming the antenna. Long press to toggle.
+bool display_meter = false;
+
+// The ring as last drawn, by ring color, and a bit for each pixel that may need redrawing.
+// The layers below remember what they drew, so a change marks only the pixels it touches.
+uint8_t ring_shown[60];
+uint8_t ring_dirty[8];
+
+// Layer state as drawn: ring mode, sample cursor, sync bar (from > to when there is
+// none), and the first pixel of each hand (-1 when hidden).
+uint8_t ring_mode = 0xff;
+uint8_t ring_sampleIndex = 0;
+int8_t ring_syncFrom = 0;
+int8_t ring_syncTo = -1;
+int8_t ring_hourPos = -1;
+int8_t ring_minutePos = -1;
+
+// Set by symbolShifted(): the symbol layer moved.
+volatile bool ring_symbolsChanged = false;
 
 // Holds input samples
 uint8_t sampleBuffer[60];
 uint8_t sampleIndex;
 
+// Raw sample capture, for recording reception to replay later. While capture_enabled,
+// tick() packs each 60 samples into capture_bits, oldest in bit 0 of byte 0, and the
+// serial task sends them as a COMMAND_SAMPLES frame with a sequence number. Not saved.
+bool capture_enabled = false;
+uint8_t capture_bits[8];
+uint8_t capture_count = 0;
+uint16_t capture_sequence = 0;
+uint8_t capture_frame[10];			// Sequence, then capture_bits
+volatile bool capture_flag = false;
+
 // Colors
 const uint32_t OFF = 0L;
-const uint32_t COLOR_SAMPLE_ONE = pixels.Color(7, 1, 0);
-const uint32_t COLOR_SAMPLE_ZERO = pixels.Color(3, 1, 6);
-const uint32_t COLOR_SAMPLE_CURSOR = pixels.Color(3, 12, 6);
+const uint32_t COLOR_SAMPLE_ONE = rgbColor(7, 1, 0);
+const uint32_t COLOR_SAMPLE_ZERO = rgbColor(3, 1, 6);
+const uint32_t COLOR_SAMPLE_CURSOR = rgbColor(3, 12, 6);
+
+const uint32_t COLOR_SYMBOL_ZERO = rgbColor(0, 0, 6);
+const uint32_t COLOR_SYMBOL_ONE = rgbColor(5, 1, 0);
+const uint32_t COLOR_SYMBOL_MARKER = rgbColor(1, 3, 1);
+
+const uint32_t COLOR_HAND_HOUR = rgbColor(40, 0, 0);
+const uint32_t COLOR_HAND_MINUTE = rgbColor(30, 18, 0);
+
+const uint32_t COLOR_SYNC = rgbColor(3, 0, 6);
+
+const uint32_t COLOR_BACKGROUND = rgbColor(1, 4, 1);
+const uint32_t COLOR_RED = rgbColor(255,0,0);
+const uint32_t COLOR_ORANGE = rgbColor(204,51,0);
+const uint32_t COLOR_YELLOW = rgbColor(255,150,0);
+const uint32_t COLOR_GREEN = rgbColor(0,255,0);
+const uint32_t COLOR_BLUE = rgbColor(0,0,255);
+const uint32_t COLOR_PURPLE = rgbColor(96,0,96);
+const uint32_t COLOR_PINK = rgbColor(60, 0, 10);
+const uint32_t COLOR_FLASH = rgbColor(255, 128, 128);
+
+const uint32_t COLOR_METER_ZERO = rgbColor(0, 0, 3);
+const uint32_t COLOR_METER_ZERO_PEAK = rgbColor(0, 0, 24);
+const uint32_t COLOR_METER_ONE = rgbColor(3, 1, 0);
+const uint32_t COLOR_METER_ONE_PEAK = rgbColor(24, 6, 0);
+const uint32_t COLOR_METER_MARKER = rgbColor(1, 2, 1);
+const uint32_t COLOR_METER_MARKER_PEAK = rgbColor(6, 18, 6);
+
+const uint32_t COLOR_TOD_FIX = rgbColor(7, 1, 0);
+const uint32_t COLOR_TOD_NOFIX = rgbColor(4, 0, 4);
+const uint32_t COLOR_TOD_ESTIMATED = rgbColor(6, 4, 0);		// Saved as power went down
+const uint32_t COLOR_TOD_STALE = rgbColor(2, 2, 5);			// Saved up to an hour before
 
-const uint32_t COLOR_SYMBOL_ZERO = pixels.Color(0, 0, 6);
-const uint32_t COLOR_SYMBOL_ONE = pixels.Color(5, 1, 0);
-const uint32_t COLOR_SYMBOL_MARKER = pixels.Color(1, 3, 1);
+// Six bytes of data for nixies
+volatile uint8_t nixieData[6];
 
-const uint32_t COLOR_HAND_HOUR = pixels.Color(40, 0, 0);
-const uint32_t COLOR_HAND_MINUTE = pixels.Color(30, 18, 0);
+// Per-slot frames for the tubes, sent from the Timer2 interrupt
+NixieEngine nixieEngine;
 
-const uint32_t COLOR_SYNC = pixels.Color(3, 0, 6);
+// Crossfade digits when the time changes
+bool nixieCrossfade = true;
 
-const uint32_t COLOR_BACKGROUND = pixels.Color(1, 4, 1);
-const uint32_t COLOR_RED = pixels.Color(255,0,0);
-const uint32_t COLOR_ORANGE = pixels.Color(204,51,0);
-const uint32_t COLOR_YELLOW = pixels.Color(255,150,0);
-const uint32_t COLOR_GREEN = pixels.Color(0,255,0);
-const uint32_t COLOR_BLUE = pixels.Color(0,0,255);
-const uint32_t COLOR_PURPLE = pixels.Color(96,0,96);
-const uint32_t COLOR_PINK = pixels.Color(60, 0, 10);
-const uint32_t COLOR_FLASH = pixels.Color(255, 128, 128);
+// Lit slots per PWM period for the two seconds tubes, so they can be dimmed against the
+// hours and minutes, or blanked. The other tubes have the full duty cycle.
+uint8_t nixieSecondsDuty = NixieEngine::slots;
+const uint8_t NIXIE_SECONDS_TUBE = 4;
 
-const uint32_t COLOR_TOD_FIX = pixels.Color(7, 1, 0);
-const uint32_t COLOR_TOD_NOFIX = pixels.Color(4, 0, 4);
+// TOP of Timer2: 16MHz / 64 / 125 = 2kHz PWM, one engine slot per PWM cycle
+const uint8_t TUBE_PWM_TOP = 124;
 
-// Six bytes of data for nixies
-volatile uint8_t nixieData[6];
+// The tubes are dark from the compare match (OCR2B) to TOP, and the next slot's frame is
+// sent then. At 4us a count, keeping OCR2B this far below TOP leaves 40us, enough to shift
+// out the six bytes and latch them (about 30us at 4MHz SPI) while the tubes are off, at
+// the cost of the top 8% of brightness.
+const uint8_t TUBE_PWM_DARK_COUNTS = 10;
+const uint8_t TUBE_PWM_MAX = TUBE_PWM_TOP - TUBE_PWM_DARK_COUNTS;
 
-// 80-bit long shift register for input samples.
-// Offset 0, bit 0 has most recent sample bit; offset 9 bit 7
-// has oldest sample bit. Shifts left. 
-volatile uint8_t samples[10];
-
-// Correlation template for a zero bit, including the trailing 0s of the preceding symbol,
-// and the leading 1s of the following symbol. From head end to tail end:
-// 10 zeroes, 12 ones, 48 zeroes, 10 ones.  Initialzing values start with LSB, which
-// is the most recent bit (the tail end of the pulse), and progress to
-// the oldest bit (the head end).  (Bytes are written LSB first, but bits in a byte are
-// MSB first!  If you get confused, print this out and read it in a mirror.)
-uint8_t PATTERN_ZERO[10] = { 0xff, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0xfc, 0x3f, 0x00 };
-// Correlaton template for one bit. From head to tail:
-// 10 zeroes, 30 ones, 30 zeroes, 10 ones
-uint8_t PATTERN_ONE[10] = { 0xff, 0x03, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0x3f, 0x00 };
-// Correlation template for marker bit. From head to tail:
-// 10 zeroes, 48 oness, 12 zeroes, 10 ones
-uint8_t PATTERN_MARKER[10] = { 0xff, 0x03, 0xc0, 0xff, 0xff, 0xff, 0xff, 0xff, 0x3f, 0x00 };
-
-// Pattern matching threshold
-uint8_t scoreThreshold = 70;
-
-// Score history buffers
-ScoreBoard scoreboard_zero = ScoreBoard();
-ScoreBoard scoreboard_one = ScoreBoard();
-ScoreBoard scoreboard_marker = ScoreBoard();
-
-// Decoded symbol stream. New symbols are shifted into position 59, and move
-// toward 0. This makes the receved word symbol positions match the documentation
-// for WWVB (i.e., Wikipedia), where bit 0 is longest ago, and bit 59 is most recent.
-char symbolStream[60];
+// Copy of nixieData being shifted out by the SPI interrupt, and the index of the
+// next byte to send. nixieTxPending is set when a new frame is queued while a
+// transfer is in progress; it is sent as soon as the current one completes.
+volatile uint8_t nixieTxFrame[6];
+volatile uint8_t nixieTxIndex = 0;
+volatile bool nixieTxBusy = false;
+volatile bool nixieTxPending = false;
+const volatile uint8_t *volatile nixieTxPendingFrame;
+
+// Correlator and symbol decoder. See WwvbDecoder.h.
+WwvbDecoder decoder;
 
 // Current time of day, UTC
 volatile uint8_t tod_ticks = 0;
@@ -257,43 +506,114 @@ volatile uint32_t tod_color = 0;
 // Set true when time has been decoded
 volatile bool tod_fix = false;
 
+// Set true when showing a time carried over from before a restart, until confirmed.
+volatile bool tod_estimated = false;
+
+// Time saved before the restart, for checking the early frame against. Saved again in
+// place of the current time until there is a fix.
+PersistentParameters warm_saved;
+
+// Timer1 count at the start of the current second. Set by tickTime().
+volatile uint32_t tod_secondStart = 0;
+
 // Set true on encoder button presses and rotation
 volatile bool rotary_down = false;
 volatile bool rotary_released = false;
 volatile bool rotary_cw = false;
 volatile bool rotary_ccw = false;
 
+// Time the button went down, and how long makes a long press
+uint32_t rotary_downMillis = 0;
+const uint16_t ROTARY_LONG_PRESS_MILLIS = 1000;
+
 // Set your time zone here!
 int8_t tzOffsetHours = -5;
 int8_t tzOffsetMinutes = 0;
 bool observeDst = true;
 
-// Operating modes
-const uint8_t MODE_SEEK = 0;
-const uint8_t MODE_SYNC = 1;
+// Cathode usage, and exercise of the least used cathodes against poisoning. Every
+// cathodeExerciseMinutes minutes, during second cathodeExerciseSecond, the tubes step
+// through the least used cathodes of each tube in place of the time. The exercise starts
+// at tick CATHODE_EXERCISE_FIRST_TICK and is over before the next second begins.
+// Usage counts are saved to EEPROM once a day.
+CathodeCare cathodeCare = CathodeCare();
+uint8_t cathodeExerciseMinutes = 15;
+uint8_t cathodeExerciseSecond = 30;
+const uint8_t CATHODE_EXERCISE_FIRST_TICK = 3;
+const uint8_t CATHODE_EXERCISE_STEP_TICKS = 18;
+volatile bool cathodeExercise_active = false;
+volatile uint8_t cathodeExerciseFrame[6];
+uint16_t cathodeCare_minutesSinceSave = 0;
+const uint16_t CATHODE_CARE_SAVE_MINUTES = 1440;
+
+// Date display: once a minute, starting at second dateDisplayStart, show the local
+// date for dateDisplaySeconds seconds, as month, day, and day of the week
+// (1 = Sunday). Set dateDisplaySeconds to 0 to always show the time.
+uint8_t dateDisplayStart = 50;
+uint8_t dateDisplaySeconds = 5;
+
+// Operating modes, kept by the decoder. Change them with setMode().
+const uint8_t MODE_SEEK = WwvbDecoder::MODE_SEEK;
+const uint8_t MODE_SYNC = WwvbDecoder::MODE_SYNC;
 
-// Current operating mode. Don't directly write it; call setMode().
-volatile uint8_t mode;
 volatile bool mode_changed = false;
 
-// State variables for MODE_SEEK
-uint8_t bitSeek_detectedSymbolCount = 0;			// No. of symbols detected since entering state
-const uint8_t bitSeek_detectedSymbolThreshold = 10;	// No. of detected symbols needed to change state
-
-// State variables for MODE_SYNC
-uint8_t bitSync_peekCountdown = 60;		// No. of ticks to wait before peeking at scoreboard for symbol
+// State variables for MODE_SYNC: drift, from the offsets of the symbols the decoder finds.
 uint32_t bitSync_localTicksSinceSync = 0;
 int16_t bitSync_accumulatedOffset = 0;
-uint8_t bitSync_missedSymbolCount = 0;				// No. of consecutive symbols missed
-const uint8_t bitSync_missedSymbolThreshold = 6;	// No. of missed symbols needed to change state
 bool bitSync_parametersSaved = false;	// Set true when current parameters saved to EEPROM
 uint32_t bitSync_localTicksSinceParameterSave = 0;
 
-// Tube PWM value
-uint8_t tube_pwm = 170;
-
-// Prepare some fake data.  This represents 10:35am June 1, 2017.
-uint8_t fakedata[] = {
+// Drift measured from the edge-timed second phase: the phase and local tick count at the
+// start of the measurement, and the last phase accepted. A phase that steps by more than
+// EDGE_PHASE_STEP_LIMIT from the last is a noise pulse or a re-phased local second, and
+// restarts the measurement. Drift past EDGE_DRIFT_THRESHOLD adjusts the tick interval.
+// All in Timer1 counts.
+const int32_t EDGE_PHASE_STEP_LIMIT = 33333;		// One tick
+const int32_t EDGE_DRIFT_THRESHOLD = 16667;			// Half a tick
+const uint32_t EDGE_DRIFT_MAX_TICKS = 36000;		// Ten minutes; keeps the counts in 32 bits
+bool bitSync_phaseValid = false;
+int32_t bitSync_phaseReference = 0;
+int32_t bitSync_phaseLast = 0;
+uint32_t bitSync_phaseReferenceTicks = 0;
+
+// Reception quality, counted by symbolShifted(), followDrift() and modeSet() over
+// a minute. Published at the end of each minute, and kept for COMMAND_METRICS.
+const uint8_t METRIC_SCORE_BUCKETS = 9;		// Peak scores 0-9, 10-19, ... 80
+typedef struct {
+	uint16_t symbolsDetected;
+	uint16_t symbolsMissed;
+	uint16_t marginTotal;			// Sum of the margins of detected symbols
+	uint16_t peakScores[METRIC_SCORE_BUCKETS];
+	uint8_t seekToSync;
+	uint8_t syncToSeek;
+	uint8_t framesAttempted;		// Markers at both ends of the symbol stream
+	uint8_t framesValid;
+	int16_t phaseCorrection;		// Sum of the decoder's sync offsets, in ticks
+	uint16_t phaseCorrectionAbs;	// Sum of their sizes
+} DecoderMetrics;
+
+DecoderMetrics metrics_minute;		// Being counted, in the ISR
+DecoderMetrics metrics_last;		// Last full minute
+int32_t metrics_totalPhaseCorrection = 0;
+uint32_t metrics_lastFixMillis = 0;
+bool metrics_everFixed = false;
+
+// Tube and pixel brightness
+Brightness brightness(Brightness::defaultMaster);
+volatile bool brightness_changed = false;
+
+// Current scale for pixel colors, from brightness
+uint8_t pixel_scale = 0;
+
+// Unscaled colors of the tube backlight and colon pixels, for redrawing them at a
+// new brightness.
+uint32_t backlight_color = 0;
+bool backlight_rainbow = true;
+uint32_t colon_color = 0;
+
+// Prepare some fake data, in flash.  This represents 10:35am June 1, 2017.
+const uint8_t fakedata[] PROGMEM = {
 	MARKER,	ZERO,	ONE,	ONE,	ZERO,	ZERO,	ONE,	ZERO,	ONE,	MARKER,  // 0-9
 	ZERO,	ZERO,	ZERO,	ONE,	ZERO,	ZERO,	ONE,	ZERO,	ZERO,	MARKER,	// 10-19
 	ZERO,	ZERO,	ZERO,	ONE,	ZERO,	ZERO,	ONE,	ZERO,	ONE,	MARKER,	// 20-29
@@ -306,8 +626,9 @@ DataGenerator fake_frame = DataGenerator(fakedata, sizeof(fakedata), 0);
 // Set true in tick(); watched and reset by main loop.
 volatile bool update_pixels_flag;
 
-// Set true by shiftSymbol(); watched and reset by main loop.
+// Set true by symbolShifted(); watched and reset by main loop.
 volatile bool valid_frame_flag = false;
+volatile bool early_frame_flag = false;
 
 // set true by bitSync(); watched and reset by main loop.
 volatile bool new_parameters_flag = false;
@@ -319,9 +640,201 @@ volatile byte encoderDataRegister = 0x00;
 
 volatile byte encoderValue = 127;
 
+// Timer1 counts per second, at the nominal crystal frequency.
+const uint32_t TIMER1_COUNTS_PER_SECOND = 2000000;
+
+// Timer1 counts (0.5us each) elapsed before the start of the current tick period,
+// and the TOP value (OCR1A) in effect for the current period. Maintained by the tick
+// ISR; read through timer1Counts().
+volatile uint32_t timer1_periodStart = 0;
+volatile uint16_t timer1_periodTop = 33333;
+
+// Edge-timed receiver front end. The pin change ISR on PIN_WWVB timestamps each edge
+// and sets edge_flag; taskEdges() assembles and classifies the pulses.
+EdgeReceiver edgeReceiver = EdgeReceiver();
+volatile bool edge_flag = false;
+
+// Result from the edge-timed front end: the phase of the last received second relative
+// to the local second, in Timer1 counts. A positive phase means the received second began
+// after the local one. Set with edge_phaseFresh by taskEdges(); taken by bitSync().
+volatile int32_t edge_phaseOffset = 0;
+volatile bool edge_phaseFresh = false;
+
+// Measures the crystal frequency against the rising edges of the received pulses.
+// Once its estimate rests on frequency_minBaselineSeconds of baseline, it sets the
+// tick interval, in place of the drift-based adjustment in bitSync().
+FrequencyEstimator frequencyEstimator = FrequencyEstimator(TIMER1_COUNTS_PER_SECOND);
+const uint16_t frequency_minBaselineSeconds = 600;
+
+// Task bodies and clock, defined below; declared here for the task table.
+void taskVccLow();
+void taskValidFrame();
+void taskEarlyFrame();
+void taskSecondChanged();
+void taskMinuteChanged();
+void taskUpdatePixels();
+void taskRotaryDown();
+void taskRotaryUp();
+void taskRotaryCw();
+void taskRotaryCcw();
+void taskSaveParameters();
+void taskSerial();
+void taskTickIntervalChanged();
+void taskEdges();
+void taskBuildNixies();
+uint32_t cycleCount();
+
+// Task names, in flash.
+const char TASK_NAME_VCC_LOW[] PROGMEM = "vccLow";
+const char TASK_NAME_FRAME[] PROGMEM = "frame";
+const char TASK_NAME_EARLY[] PROGMEM = "early";
+const char TASK_NAME_NIXIES[] PROGMEM = "nixies";
+const char TASK_NAME_SECOND[] PROGMEM = "second";
+const char TASK_NAME_MINUTE[] PROGMEM = "minute";
+const char TASK_NAME_PIXELS[] PROGMEM = "pixels";
+const char TASK_NAME_EDGES[] PROGMEM = "edges";
+const char TASK_NAME_ROT_PUSH[] PROGMEM = "rotPush";
+const char TASK_NAME_ROT_UP[] PROGMEM = "rotUp";
+const char TASK_NAME_ROT_CW[] PROGMEM = "rotCw";
+const char TASK_NAME_ROT_CCW[] PROGMEM = "rotCcw";
+const char TASK_NAME_SERIAL[] PROGMEM = "serial";
+const char TASK_NAME_SAVE[] PROGMEM = "save";
+const char TASK_NAME_INTERVAL[] PROGMEM = "interval";
+
+// Work done by the main loop. The lowest priority value runs first; deadlines are
+// in CPU cycles (16 per microsecond), measured from the time the scheduler notices
+// the release to the time the task completes.
+Task tasks[] = {
+	// name					function					release flag			period	priority	deadline
+	{ TASK_NAME_VCC_LOW,	taskVccLow,					&vcc_low_flag,			0,		0,			0 },
+	{ TASK_NAME_FRAME,		taskValidFrame,				&valid_frame_flag,		0,		0,			266666 },	// 1 tick
+	{ TASK_NAME_EARLY,		taskEarlyFrame,				&early_frame_flag,		0,		0,			266666 },	// 1 tick
+	{ TASK_NAME_NIXIES,		taskBuildNixies,			nixieEngine.getBuildFlag(),	0,	1,			64000 },	// 4ms, one engine period
+	{ TASK_NAME_SECOND,		taskSecondChanged,			&tod_secondChanged,		0,		1,			16000 },	// 1ms
+	{ TASK_NAME_MINUTE,		taskMinuteChanged,			&tod_minuteChanged,		0,		2,			0 },
+	{ TASK_NAME_PIXELS,		taskUpdatePixels,			&update_pixels_flag,	0,		3,			266666 },	// 1 tick
+	{ TASK_NAME_EDGES,		taskEdges,					&edge_flag,				6,		4,			0 },
+	{ TASK_NAME_ROT_PUSH,	taskRotaryDown,				&rotary_down,			0,		5,			0 },
+	{ TASK_NAME_ROT_UP,		taskRotaryUp,				&rotary_released,		0,		5,			0 },
+	{ TASK_NAME_ROT_CW,		taskRotaryCw,				&rotary_cw,				0,		5,			0 },
+	{ TASK_NAME_ROT_CCW,	taskRotaryCcw,				&rotary_ccw,			0,		5,			0 },
+	{ TASK_NAME_SERIAL,		taskSerial,					NULL,					1,		6,			0 },
+	{ TASK_NAME_SAVE,		taskSaveParameters,			NULL,					60,		6,			0 },
+	{ TASK_NAME_INTERVAL,	taskTickIntervalChanged,	&tick_interval_changed,	0,		7,			0 },
+};
+
+Scheduler scheduler = Scheduler(tasks, sizeof(tasks) / sizeof(Task), cycleCount);
+
+// Commands over the serial port. Each gets a reply with the top bit of the command set,
+// or a COMMAND_ERROR reply holding the command and an error code. Multi-byte values are
+// little endian.
+const uint8_t COMMAND_PING = 0x01;				// Reply: protocol version
+const uint8_t COMMAND_GET_SETTING = 0x02;		// Setting index. Reply: index, value (int16)
+const uint8_t COMMAND_SET_SETTING = 0x03;		// Setting index, value (int16). Reply: as GET
+const uint8_t COMMAND_SAVE = 0x04;				// Save settings and parameters to EEPROM
+const uint8_t COMMAND_TASK_STATS = 0x05;		// Task index. Reply: index, count, TaskStats, name
+const uint8_t COMMAND_PROFILE = 0x06;			// Segment index, reset after (optional). Reply: index, count, ProfileStats
+const uint8_t COMMAND_MEMORY = 0x07;			// Reply: MemoryStats
+const uint8_t COMMAND_METRICS = 0x08;			// Reply: MetricsReport. Also sent unasked each minute.
+const uint8_t COMMAND_SAMPLES = 0x09;			// Only sent, each second while capturing: sequence, 60 samples
+const uint8_t COMMAND_ERROR = 0x7f;
+const uint8_t COMMAND_REPLY = 0x80;
+
+const uint8_t COMMAND_PROTOCOL_VERSION = 1;
+
+const uint8_t ERROR_UNKNOWN_COMMAND = 1;
+const uint8_t ERROR_BAD_LENGTH = 2;
+const uint8_t ERROR_BAD_INDEX = 3;
+const uint8_t ERROR_OUT_OF_RANGE = 4;
+const uint8_t ERROR_BUSY = 5;
+
+CommandParser commandParser;
+
+// Task statistics as sent in reply to COMMAND_TASK_STATS.
+typedef struct {
+	uint32_t runCount;
+	uint32_t meanCycles;
+	uint32_t maxCycles;
+	uint32_t maxLatencyCycles;
+	uint16_t deadlineMisses;
+} TaskStats;
+
+// Profiler segment as sent in reply to COMMAND_PROFILE. Times in Timer1 counts (0.5us).
+typedef struct {
+	uint32_t count;
+	uint16_t min;
+	uint16_t max;
+	uint16_t mean;
+	uint16_t histogram[Profiler::buckets];
+} ProfileStats;
+
+// Decoder quality as sent for COMMAND_METRICS: the last full minute, and the running totals.
+typedef struct {
+	DecoderMetrics minute;
+	uint32_t secondsSinceFix;		// 0xffffffff before the first fix
+	int32_t totalPhaseCorrection;	// Ticks, since startup
+	uint8_t mode;
+	uint8_t fix;
+} MetricsReport;
+
+// SRAM use as sent in reply to COMMAND_MEMORY, in bytes.
+typedef struct {
+	uint16_t staticData;
+	uint16_t stackRegion;
+	uint16_t stackHighWater;
+	uint16_t stackFree;
+} MemoryStats;
+
+// Warn when the stack has come within this many bytes of the static data.
+const uint16_t STACK_MARGIN = 64;
+bool stack_warned = false;
+
+// Settings that can be changed over the serial link, and saved with the parameters.
+const uint8_t SETTING_INT8 = 0;
+const uint8_t SETTING_UINT8 = 1;
+const uint8_t SETTING_BOOL = 2;
+
+typedef struct {
+	void *value;
+	uint8_t type;
+	int16_t min;
+	int16_t max;
+} Setting;
+
+// Indexes into the settings table.
+enum {
+	SETTING_TZ_HOURS,
+	SETTING_TZ_MINUTES,
+	SETTING_OBSERVE_DST,
+	SETTING_OVERRIDE,
+	SETTING_SCORE_THRESHOLD,
+	SETTING_DETECTED_THRESHOLD,
+	SETTING_MISSED_THRESHOLD,
+	SETTING_CAPTURE,
+	SETTING_SECONDS_DUTY,
+	SETTING_COUNT
+};
+
+Setting settings[SETTING_COUNT] = {
+	// value							type			min		max
+	{ &tzOffsetHours,					SETTING_INT8,	-12,	14 },
+	{ &tzOffsetMinutes,					SETTING_INT8,	-59,	59 },
+	{ &observeDst,						SETTING_BOOL,	0,		1 },
+	{ &overrideSavedParameters,			SETTING_BOOL,	0,		1 },
+	{ &decoder.scoreThreshold,			SETTING_UINT8,	1,		80 },
+	{ &decoder.detectedSymbolThreshold,	SETTING_UINT8,	1,		60 },
+	{ &decoder.missedSymbolThreshold,	SETTING_UINT8,	1,		60 },
+	{ &capture_enabled,					SETTING_BOOL,	0,		1 },
+	{ &nixieSecondsDuty,				SETTING_UINT8,	0,		NixieEngine::slots },
+};
+
 // One-time setup at start
 void setup() {
 
+	// After a watchdog or external reset, pick up the time where it was. The ticks from
+	// the reset until the tick timer starts, further down, are lost; see recoverState().
+	bool recovered = recoverState();
+
 	// Configure PWM for tube dimming
 	pinMode(PIN_PWM, OUTPUT);
 
@@ -351,11 +864,23 @@ void setup() {
 	// enable interrupt for the group
 	PCICR  |= bit (digitalPinToPCICRbit(PIN_ROT_PB));
 
+	// Enable pin change interrupt on the receiver output, for edge timing
+	*digitalPinToPCMSK(PIN_WWVB) |= bit (digitalPinToPCMSKbit(PIN_WWVB));
+	PCIFR  |= bit (digitalPinToPCICRbit(PIN_WWVB));
+	PCICR  |= bit (digitalPinToPCICRbit(PIN_WWVB));
+
 	configureTickTimer();
-	configurePwmTimer();
 
-	// Configure SPI pins
+	// Configure SPI pins. The bus is dedicated to the nixie registers, so configure it
+	// once and leave it to the SPI interrupt to drive transfers.
 	SPI.begin();
+	SPI.beginTransaction(SPISettings(NIXIE_SPI_CLOCK, MSBFIRST, SPI_MODE0));
+	SPCR |= _BV(SPIE);
+
+	// The PWM timer interrupt sends nixie frames, so start it once SPI is ready.
+	configurePwmTimer();
+
+	configureVccMonitor();
 
 	// Configure neopixels
 	pixels.begin();
@@ -364,11 +889,21 @@ void setup() {
 	setBacklightRainbow();
 	Serial.begin(230400);
 
-	setTubePwm(170);
+	Serial.print(F("SRAM: "));
+	Serial.print(staticDataSize());
+	Serial.print(F(" bytes static, "));
+	Serial.print(stackRegionSize());
+	Serial.print(F(" for the stack.\n"));
 
+	setTubePwm(brightness.getTubeLevel());
+	brightness.fadeIn(2);
+
+	if (!cathodeCare.load(CATHODE_CARE_ADDRESS))
+		Serial.print(F("No saved cathode usage.\n"));
+
+	configureFromMemory();
 	if (!overrideSavedParameters) {
-		configureFromMemory();
-		Serial.print("Using stored parameters: ");
+		Serial.print(F("Using stored parameters: "));
 		Serial.print(tick_interval_cycles);
 		Serial.print(' ');
 		Serial.print(tick_frac_numerator);
@@ -377,7 +912,7 @@ void setup() {
 		Serial.print('\n');
 	}
 	else {
-		Serial.print("Overriding parameters: ");
+		Serial.print(F("Overriding parameters: "));
 		Serial.print(tick_interval_cycles);
 		Serial.print(' ');
 		Serial.print(tick_frac_numerator);
@@ -386,311 +921,1007 @@ void setup() {
 		Serial.print('\n');
 	}
 
-	setMode(MODE_SEEK);
+	if (recovered) {
+		// The tick interval from before the reset is newer than the saved one.
+		tick_interval_cycles = recovery.tickIntervalCycles;
+		tick_frac_numerator = recovery.tickFracNumerator;
+		Serial.print(F("Recovered after reset (MCUSR "));
+		Serial.print(reset_cause, HEX);
+		Serial.print(F("): "));
+		printTimeUtc();
+
+		// A time recovered as an estimate is confirmed against itself by the early frame
+		// check, rather than against the older one in the journal.
+		if (tod_estimated)
+			storeTime(&warm_saved, false);
+
+		// After an external reset the phase of the received seconds is lost, so seek it.
+		bool external = reset_cause & _BV(EXTRF);
+		setMode(recovery.mode == MODE_SYNC  &&  !external ? MODE_SYNC : MODE_SEEK);
+	}
+	// With a saved time, show it straight away. The phase of the received seconds is
+	// still unknown, so seek them as usual; the symbols seen while seeking go into the
+	// stream, and the first frame's hours and minutes will confirm the time.
+	else {
+		if (!overrideSavedParameters  &&  warmStart()) {
+			Serial.print(F("Warm start: "));
+			printTimeUtc();
+		}
+		setMode(MODE_SEEK);
+	}
+
+	recovery_armed = true;
+	wdt_enable(WDTO_500MS);
 }
 
-// Main processing loop. Polls various aspects, and updates display / writes messages
-// as they change.
-// Time of day: Updates numeric display.
-// Tick interval period: Stores in EEPROM.
-// Operating mode: Write a message.
-// Rotary control: do the things.
+// Main processing loop. Runs the tasks in the task table, most urgent first, as their
+// flags are raised by the ISRs or their periods elapse.
 void loop() {
-	if (valid_frame_flag) {
-		valid_frame_flag = false;
-		
-		Serial.print("Valid frame!\n");
-		for (int i=0;  i<60;  i++) {
-			pixels.setPixelColor(i+PIXEL_OFFSET_RING, tod_color);
-		}
-		Serial.print('\n');
+	loop_progress = true;
 
-		Serial.print("Tick interval: ");
-		Serial.print(tick_interval_cycles);
-		Serial.print(' ');
-		Serial.print(tick_frac_numerator);
-		Serial.print('/');
-		Serial.print(tick_frac_denominator);
-		Serial.print('\n');
+	uint32_t start = timer1Counts();
+	if (heartbeatShowsLoad) {
+		loop_busy = true;
+		HeartbeatPin::high();
+	}
 
-		// Set time of day from the symbol frame, taking processing time offset into account.
-		decodeTimeOfDay(10 + ScoreBoard::centerIndex);
-		tod_fix = true;
+	bool ran = scheduler.runNext();
 
-		printTimeUtc();
+	if (heartbeatShowsLoad) {
+		loop_busy = false;
+		HeartbeatPin::low();
+	}
+	if (ran) {
+		uint32_t counts = timer1Counts() - start;
+		profiler.record(PROFILE_TASK, counts > 0xffff ? 0xffff : counts);
 	}
+}
 
-	if (tod_minuteChanged) {
-		if (tod_fix) {
-			//tod_color = minuteColor(tod_hours, tod_minutes);
-			tod_color = COLOR_TOD_FIX;
-		}
-		else {
-			tod_color = COLOR_TOD_NOFIX;
-		}
-		tod_minuteChanged = false;
+// Valid frame received: set time of day from the symbol frame.
+void taskValidFrame() {
+	Serial.print(F("Valid frame!\n"));
+	ringAnimation.play(ANIMATION_FIX_FLASH, false);
+
+	Serial.print(F("Tick interval: "));
+	Serial.print(tick_interval_cycles);
+	Serial.print(' ');
+	Serial.print(tick_frac_numerator);
+	Serial.print('/');
+	Serial.print(tick_frac_denominator);
+	Serial.print('\n');
+
+	// Set time of day from the symbol frame, taking processing time offset into account.
+	decodeTimeOfDay(WwvbDecoder::decodeDelayTicks);
+	tod_fix = true;
+	metrics_lastFixMillis = millis();
+	metrics_everFixed = true;
+	tod_estimated = false;
+	tod_color = COLOR_TOD_FIX;
+
+	printTimeUtc();
+}
+
+// First 20 symbols of a frame after a warm start: if its hours and minutes agree with
+// the saved time, take them with the saved date. The next full frame sets the date.
+void taskEarlyFrame() {
+	if (tod_fix  ||  !tod_estimated)
+		return;
+
+	// Position 19 of the frame has just been shifted in.
+	if (!decodeEarlyFrame(WwvbDecoder::decodeDelayTicks)) {
+		Serial.print(F("Early frame disagrees with saved time.\n"));
+		return;
 	}
 
-	if (tod_secondChanged) {
-		if (tod_fix) {
-			if (observeDst && tod_isdst)
-				updateTimeOfDayLocal(tzOffsetHours+1, tzOffsetMinutes, false);
-			else
-				updateTimeOfDayLocal(tzOffsetHours, tzOffsetMinutes, false);
-			
-		}
+	Serial.print(F("Early frame: "));
+	ringAnimation.play(ANIMATION_FIX_FLASH, false);
+	tod_fix = true;
+	metrics_lastFixMillis = millis();
+	metrics_everFixed = true;
+	tod_estimated = false;
+	tod_color = COLOR_TOD_FIX;
+
+	printTimeUtc();
+}
+
+// Time of day: Updates numeric display.
+void taskSecondChanged() {
+	if (tod_fix  ||  tod_estimated) {
+		bool showDate = tod_seconds >= dateDisplayStart  &&  tod_seconds < dateDisplayStart + dateDisplaySeconds;
+
+		if (observeDst && tod_isdst)
+			updateTimeOfDayLocal(tzOffsetHours+1, tzOffsetMinutes, false, showDate);
 		else
-			updateTimeOfDayUtc();
+			updateTimeOfDayLocal(tzOffsetHours, tzOffsetMinutes, false, showDate);
+		
+	}
+	else
+		updateTimeOfDayUtc();
 
-		updateNixies();
-		tod_secondChanged = false;
-	}
-
-	//if (mode_changed) {
-	//	mode_changed = false;
-	//	Serial.print("Mode changed to ");
-	//	switch(mode) {
-	//		case MODE_SEEK:
-	//			Serial.print("MODE_SEEK");
-	//			break;
-	//		case MODE_SYNC:
-	//			Serial.print("MODE_SYNC");
-	//			break;
-//
-	//		default:
-	//			Serial.print("unknown mode: ");
-	//			Serial.print(mode);			
-	//	}
-	//	Serial.print('\n');
-	//}
-
-	if (tick_interval_changed) {
-		tick_interval_changed = false;
-		Serial.print("New tick interval: ");
-		Serial.print(tick_interval_cycles);
-		Serial.print(' ');
-		Serial.print(tick_frac_numerator);
-		Serial.print('/');
-		Serial.print(tick_frac_denominator);
-		Serial.print('\n');
+	updateNixies();
+	cathodeCare.account(nixieData);
+
+	// Time for a cathode exercise? The tick ISR runs it.
+	if (tod_fix  &&  cathodeExerciseMinutes > 0  &&  tod_seconds == cathodeExerciseSecond
+			&&  tod_minutes % cathodeExerciseMinutes == 0) {
+		cathodeCare.planExercise();
+		cathodeExercise_active = true;
+	}
+}
+
+void taskMinuteChanged() {
+	if (tod_fix) {
+		//tod_color = minuteColor(tod_hours, tod_minutes);
+		tod_color = COLOR_TOD_FIX;
+
+		// Keep a recent time in the journal for a warm start, in case the supply goes
+		// down too fast to save it then.
+		if (tod_minutes == 0)
+			saveParameters(false);
+	}
+	else if (!tod_estimated) {
+		tod_color = COLOR_TOD_NOFIX;
+	}
+
+	applyFrequencyEstimate();
+	publishMetrics();
+
+	// Stack getting near the static data?
+	if (!stack_warned  &&  stackRegionSize() > 0  &&  stackHighWater() + STACK_MARGIN > stackRegionSize()) {
+		Serial.print(F("Stack low: "));
+		Serial.print(stackHighWater());
+		Serial.print(F(" bytes used.\n"));
+		stack_warned = true;
+	}
+
+	// Sweep the ring, unless it is still flashing for a new fix.
+	if (tod_fix  &&  decoder.getMode() == MODE_SYNC  &&  !ringAnimation.isPlaying(ANIMATION_FIX_FLASH))
+		ringAnimation.play(ANIMATION_MINUTE_TRANSITION, false);
+
+	// Try again next minute if the writer is busy.
+	if (++cathodeCare_minutesSinceSave >= CATHODE_CARE_SAVE_MINUTES) {
+		if (cathodeCare.save(&eepromWriter, CATHODE_CARE_ADDRESS))
+			cathodeCare_minutesSinceSave = 0;
+	}
+}
+
+void taskUpdatePixels() {
+	// Leave the pixels dark while the supply is low.
+	if (vcc_shed) {
+		if (vcc_low)
+			return;
+		restoreLoad();
 	}
 
+	if (brightness_changed) {
+		brightness_changed = false;
+		applyPixelBrightness();
+	}
+
+	// Spin while waiting for a frame in sync mode.
+	bool waiting = decoder.getMode() == MODE_SYNC  &&  !tod_fix  &&  !display_meter;
+	if (waiting  &&  !ringAnimation.isActive())
+		ringAnimation.play(ANIMATION_ACQUISITION_SPINNER, true);
+	else if (!waiting  &&  ringAnimation.isPlaying(ANIMATION_ACQUISITION_SPINNER))
+		ringAnimation.stop();
+
+	ringAnimation.step();
+	updatePixels();
+
+	// Push what changed. The chain is sent in segments with interrupts enabled between
+	// them, so this runs here rather than in the tick ISR.
+	pixels.show();
+}
+
+// Rotary control: do the things.
+void taskRotaryDown() {
+	rotary_downMillis = millis();
+}
+
+void taskRotaryUp() {
+	if (millis() - rotary_downMillis >= ROTARY_LONG_PRESS_MILLIS) {
+		// Long press: toggle the correlator meter
+		display_meter = !display_meter;
+		return;
+	}
+
+	// Change display mode
+	if (decoder.getMode() == MODE_SEEK) {
+		setMode(MODE_SYNC);
+	}
+	else {
+		setMode(MODE_SEEK);
+	}
+}
+
+void taskRotaryCw() {
+	// Increase brightness
+	uint8_t level = brightness.getMaster();
+	if (level < 250) {
+		brightness.setMaster(level + 5);
+		applyBrightness();
+	}
+}
+
+void taskRotaryCcw() {
+	// Decrease brightness
+	uint8_t level = brightness.getMaster();
+	if (level > 10) {
+		brightness.setMaster(level - 5);
+		applyBrightness();
+	}
+}
+
+// Show a new brightness level: tubes now, pixels on the next pixel update.
+void applyBrightness() {
+	setTubePwm(brightness.getTubeLevel());
+	brightness_changed = true;
+}
+
+// Redraw every pixel at the current brightness, from the colors already chosen. The ring
+// is redrawn from its composed colors, without going through the layers again.
+void applyPixelBrightness() {
+	pixel_scale = brightness.getPixelScale();
+
+	for (uint8_t i = 0;  i<60;  i++)
+		pixels.setPixelColor(i+PIXEL_OFFSET_RING, scaleColor(ringColor(ring_shown[i]), pixel_scale));
+
+	showBacklight();
+	showColon();
+}
+
+// Tick interval period: Stores in EEPROM. Runs once a second.
+void taskSaveParameters() {
 	if (unsaved_parameters) {
 		// Have we gone long enough to save the parameters?
-		if (bitSync_localTicksSinceParameterSave > 500000) {
-			PersistentParameters params;
-			params.version = parametersVersion;
-			params.scaledCounts = (uint32_t) tick_interval_cycles * tick_frac_denominator + tick_frac_numerator;
-			saveParameters(0, &params);
-			bitSync_parametersSaved = true;
-			Serial.print("Saved parameters to EEPROM.\n");
-			bitSync_localTicksSinceParameterSave = 0;
-			unsaved_parameters = false;
-		}
+		if (bitSync_localTicksSinceParameterSave > PARAMETER_SAVE_TICKS)
+			saveParameters(false);
 	}
+}
 
-	if (update_pixels_flag) {
-		updatePixels();
-		update_pixels_flag = false;
+// Serial port: run the commands that have come in.
+void taskSerial() {
+	while (Serial.available() > 0) {
+		if (commandParser.feed(Serial.read()))
+			runCommand(commandParser.getCommand(), commandParser.getPayload(), commandParser.getLength());
 	}
 
-	if (rotary_down) {
-		// Change display mode
-		if (mode == MODE_SEEK) {
-			setMode(MODE_SYNC);
-		}
-		else {
-			setMode(MODE_SEEK);
-		}
-		rotary_down = false;
+	if (capture_flag) {
+		capture_flag = false;
+		CommandParser::send(&Serial, COMMAND_SAMPLES | COMMAND_REPLY, capture_frame, sizeof(capture_frame));
 	}
+}
 
-	if (rotary_cw) {
-		// Increase brightness
-		if (tube_pwm < 250) {
-			tube_pwm += 5;
-			setTubePwm(tube_pwm);
-		}
-		rotary_cw = false;
+// Supply going down: shed the load, then save what isn't saved, and hope the reservoir
+// capacitors hold up long enough for it to be written. A save the journal or the EEPROM
+// writer can't take yet is retried on the next pass of the loop, ahead of other tasks.
+void taskVccLow() {
+	if (!vcc_shed) {
+		Serial.print(F("Supply low: "));
+		Serial.print(vccMillivolts());
+		Serial.print(F("mV. Saving.\n"));
+
+		shedLoad();
+
+		// Save the time as well, for a warm start.
+		vcc_parametersPending = unsaved_parameters  ||  tod_fix;
+		vcc_cathodeCarePending = true;
 	}
 
-	if (rotary_ccw) {
-		// Decrease brightness
-		if (tube_pwm > 10) {
-			tube_pwm -= 5;
-			setTubePwm(tube_pwm);
-		}
-		rotary_ccw = false;
+	if (vcc_parametersPending  &&  saveParameters(true))
+		vcc_parametersPending = false;
+
+	if (vcc_cathodeCarePending  &&  cathodeCare.save(&eepromWriter, CATHODE_CARE_ADDRESS)) {
+		vcc_cathodeCarePending = false;
+		cathodeCare_minutesSinceSave = 0;
 	}
 
+	if (vcc_parametersPending  ||  vcc_cathodeCarePending)
+		vcc_low_flag = true;
 }
 
+// Turn off the HV supply, which blanks the tubes, and the pixels: together they draw
+// most of the current, and the EEPROM writes need the reservoir to last.
+void shedLoad() {
+	vcc_shed = true;
+	digitalWrite(PIN_HV, HIGH);
 
+	for (uint8_t i=0;  i<PIXEL_COUNT;  i++)
+		pixels.setPixelColor(i, 0);
+	pixels.show();
+}
+
+// Supply back up: turn the HV supply on, and redraw the pixels from their colors.
+void restoreLoad() {
+	vcc_shed = false;
+	digitalWrite(PIN_HV, LOW);
+	brightness_changed = true;
+}
+
+// Copy the time of day into parameters, marked valid.
+void storeTime(PersistentParameters *params, bool powerLoss) {
+	params->timeFlags = SAVED_TIME_VALID;
+	if (tod_isleapyear) params->timeFlags |= SAVED_TIME_LEAP_YEAR;
+	if (tod_isdst) params->timeFlags |= SAVED_TIME_DST;
+	if (powerLoss) params->timeFlags |= SAVED_TIME_POWER_LOSS;
+	params->year = tod_year - 2000;
+	params->day = tod_day;
+	params->hours = tod_hours;
+	params->minutes = tod_minutes;
+	params->seconds = tod_seconds;
+}
+
+// Queue the tick interval, the settings, and the time when there is a fix, for saving to
+// the journal. Without a fix, the time saved before the restart is carried forward, so
+// that a save while the time is only estimated doesn't lose the last good one. Returns
+// false if the last save is still being written; try again later.
+bool saveParameters(bool powerLoss) {
+	PersistentParameters params;
+	params.version = parametersVersion;
+	params.scaledCounts = (uint32_t) tick_interval_cycles * tick_frac_denominator + tick_frac_numerator;
+
+	if (tod_fix)
+		storeTime(&params, powerLoss);
+	else {
+		params.timeFlags = warm_saved.timeFlags;
+		params.year = warm_saved.year;
+		params.day = warm_saved.day;
+		params.hours = warm_saved.hours;
+		params.minutes = warm_saved.minutes;
+		params.seconds = warm_saved.seconds;
+	}
+	storeSettings(&params);
+
+	if (!journal.append(params.version, &params, sizeof(params)))
+		return false;
+
+	bitSync_parametersSaved = true;
+	Serial.print(F("Saving parameters to EEPROM.\n"));
+	bitSync_localTicksSinceParameterSave = 0;
+	unsaved_parameters = false;
+	return true;
+}
+
+// Carry out a command from the serial port, and send the reply.
+void runCommand(uint8_t command, const uint8_t *payload, uint8_t length) {
+	uint8_t reply[1];
+
+	switch (command) {
+		case COMMAND_PING:
+			reply[0] = COMMAND_PROTOCOL_VERSION;
+			CommandParser::send(&Serial, command | COMMAND_REPLY, reply, 1);
+			return;
+
+		case COMMAND_SET_SETTING:
+			if (length != 3) {
+				sendCommandError(command, ERROR_BAD_LENGTH);
+				return;
+			}
+			if (payload[0] >= SETTING_COUNT) {
+				sendCommandError(command, ERROR_BAD_INDEX);
+				return;
+			}
+			if (!setSetting(payload[0], (int16_t)(payload[1] | payload[2] << 8))) {
+				sendCommandError(command, ERROR_OUT_OF_RANGE);
+				return;
+			}
+			// Reply with the new value, as for a get.
+			sendSetting(command, payload[0]);
+			return;
+
+		case COMMAND_GET_SETTING:
+			if (length < 1) {
+				sendCommandError(command, ERROR_BAD_LENGTH);
+				return;
+			}
+			if (payload[0] >= SETTING_COUNT) {
+				sendCommandError(command, ERROR_BAD_INDEX);
+				return;
+			}
+			sendSetting(command, payload[0]);
+			return;
+
+		case COMMAND_SAVE:
+			if (!saveParameters(false)) {
+				sendCommandError(command, ERROR_BUSY);
+				return;
+			}
+			CommandParser::send(&Serial, command | COMMAND_REPLY, NULL, 0);
+			return;
+
+		case COMMAND_TASK_STATS:
+			if (length != 1) {
+				sendCommandError(command, ERROR_BAD_LENGTH);
+				return;
+			}
+			if (payload[0] >= scheduler.getCount()) {
+				sendCommandError(command, ERROR_BAD_INDEX);
+				return;
+			}
+			sendTaskStats(payload[0]);
+			return;
+
+		case COMMAND_MEMORY:
+			{
+				MemoryStats stats;
+				stats.staticData = staticDataSize();
+				stats.stackRegion = stackRegionSize();
+				stats.stackHighWater = stackHighWater();
+				stats.stackFree = stackFree();
+				CommandParser::send(&Serial, command | COMMAND_REPLY, &stats, sizeof(stats));
+			}
+			return;
+
+		case COMMAND_METRICS:
+			sendMetrics();
+			return;
+
+		case COMMAND_PROFILE:
+			if (length < 1  ||  length > 2) {
+				sendCommandError(command, ERROR_BAD_LENGTH);
+				return;
+			}
+			if (payload[0] >= profiler.getCount()) {
+				sendCommandError(command, ERROR_BAD_INDEX);
+				return;
+			}
+			sendProfile(payload[0]);
+			if (length == 2  &&  payload[1])
+				profiler.reset(payload[0]);
+			return;
+	}
+
+	sendCommandError(command, ERROR_UNKNOWN_COMMAND);
+}
+
+void sendCommandError(uint8_t command, uint8_t error) {
+	uint8_t reply[2] = { command, error };
+	CommandParser::send(&Serial, COMMAND_ERROR, reply, 2);
+}
+
+// Reply to COMMAND_GET_SETTING or COMMAND_SET_SETTING: setting index, then its value.
+void sendSetting(uint8_t command, uint8_t index) {
+	int16_t value = getSetting(index);
+	uint8_t reply[3] = { index, (uint8_t)(value & 0xff), (uint8_t)(value >> 8) };
+	CommandParser::send(&Serial, command | COMMAND_REPLY, reply, 3);
+}
+
+// Reply to COMMAND_TASK_STATS: task index, task count, statistics, then the name.
+void sendTaskStats(uint8_t index) {
+	Task *task = scheduler.getTask(index);
+	uint8_t reply[2 + sizeof(TaskStats) + 8];
+	TaskStats stats;
+
+	stats.runCount = task->runCount;
+	stats.meanCycles = task->runCount ? task->totalCycles / task->runCount : 0;
+	stats.maxCycles = task->maxCycles;
+	stats.maxLatencyCycles = task->maxLatencyCycles;
+	stats.deadlineMisses = task->deadlineMisses;
+
+	reply[0] = index;
+	reply[1] = scheduler.getCount();
+	memcpy(&reply[2], &stats, sizeof(stats));
+	uint8_t nameLength = strlen_P(task->name);
+	if (nameLength > 8)
+		nameLength = 8;
+	memcpy_P(&reply[2 + sizeof(stats)], task->name, nameLength);
+
+	CommandParser::send(&Serial, COMMAND_TASK_STATS | COMMAND_REPLY, reply, 2 + sizeof(stats) + nameLength);
+}
+
+// End of a minute: keep the minute's quality counts, start counting afresh, and send them.
+void publishMetrics() {
+	uint8_t oldSREG = SREG;
+	cli();
+	metrics_last = metrics_minute;
+	memset(&metrics_minute, 0, sizeof(metrics_minute));
+	SREG = oldSREG;
+
+	metrics_totalPhaseCorrection += metrics_last.phaseCorrection;
+	sendMetrics();
+}
+
+void sendMetrics() {
+	MetricsReport report;
+
+	report.minute = metrics_last;
+	report.secondsSinceFix = metrics_everFixed ? (millis() - metrics_lastFixMillis) / 1000 : 0xffffffff;
+	report.totalPhaseCorrection = metrics_totalPhaseCorrection;
+	report.mode = decoder.getMode();
+	report.fix = tod_fix;
+
+	CommandParser::send(&Serial, COMMAND_METRICS | COMMAND_REPLY, &report, sizeof(report));
+}
+
+// Reply to COMMAND_PROFILE: segment index, segment count, then the statistics.
+void sendProfile(uint8_t index) {
+	uint8_t reply[2 + sizeof(ProfileStats)];
+	Profiler::Segment segment;
+	ProfileStats stats;
+
+	profiler.read(index, &segment);
+	stats.count = segment.count;
+	stats.min = segment.count ? segment.min : 0;
+	stats.max = segment.max;
+	stats.mean = segment.count ? segment.total / segment.count : 0;
+	memcpy(stats.histogram, segment.histogram, sizeof(stats.histogram));
+
+	reply[0] = index;
+	reply[1] = profiler.getCount();
+	memcpy(&reply[2], &stats, sizeof(stats));
+
+	CommandParser::send(&Serial, COMMAND_PROFILE | COMMAND_REPLY, reply, sizeof(reply));
+}
+
+int16_t getSetting(uint8_t index) {
+	Setting *setting = &settings[index];
+
+	switch (setting->type) {
+		case SETTING_INT8:
+			return *(int8_t *)setting->value;
+		case SETTING_BOOL:
+			return *(bool *)setting->value;
+		default:
+			return *(uint8_t *)setting->value;
+	}
+}
+
+// Change a setting. Returns false, leaving it alone, if the value is out of range.
+bool setSetting(uint8_t index, int16_t value) {
+	Setting *setting = &settings[index];
+
+	if (value < setting->min  ||  value > setting->max)
+		return false;
+
+	switch (setting->type) {
+		case SETTING_INT8:
+			*(int8_t *)setting->value = value;
+			break;
+		case SETTING_BOOL:
+			*(bool *)setting->value = value != 0;
+			break;
+		default:
+			*(uint8_t *)setting->value = value;
+			break;
+	}
+
+	if (index == SETTING_SECONDS_DUTY)
+		applySecondsDuty();
+	if (index == SETTING_CAPTURE  &&  capture_enabled)
+		restartCapture();
+	return true;
+}
+
+// Start a capture on a whole frame of samples, dropping any left from the last one.
+void restartCapture() {
+	// Written by the tick ISR.
+	uint8_t oldSREG = SREG;
+	cli();
+	memset(capture_bits, 0, sizeof(capture_bits));
+	capture_count = 0;
+	SREG = oldSREG;
+}
+
+// Give the seconds tubes their duty cycle.
+void applySecondsDuty() {
+	nixieEngine.setDuty(NIXIE_SECONDS_TUBE, nixieSecondsDuty);
+	nixieEngine.setDuty(NIXIE_SECONDS_TUBE + 1, nixieSecondsDuty);
+}
+
+// Receiver edges: assemble timestamped edges into pulses, and measure the phase of
+// each valid one against the local second. Also runs periodically to finish
+// a pulse that has no following edge yet.
+void taskEdges() {
+	Pulse pulse;
+
+	while (edgeReceiver.nextPulse(timer1Counts(), &pulse)) {
+		if (pulse.symbol == 0)
+			continue;
+
+		int32_t phase = secondPhase(pulse.start);
+
+		// Both are read by the tick ISR.
+		uint8_t oldSREG = SREG;
+		cli();
+		edge_phaseOffset = phase;
+		edge_phaseFresh = true;
+		SREG = oldSREG;
+
+		frequencyEstimator.addEdge(pulse.start);
+	}
+}
+
+// True when the frequency estimate rests on a long enough baseline to set the tick interval.
+bool frequencyLocked() {
+	return frequencyEstimator.getEstimateSeconds() >= frequency_minBaselineSeconds;
+}
+
+// Set the tick interval from the measured crystal frequency, when the estimator
+// is locked and the estimate differs from the current interval.
+void applyFrequencyEstimate() {
+	if (!frequencyLocked())
+		return;
+
+	uint32_t scaledCounts = frequencyEstimator.getScaledTickCounts(60, tick_frac_denominator);
+	uint32_t currentCounts = (uint32_t)tick_interval_cycles * tick_frac_denominator + tick_frac_numerator;
+	if (scaledCounts == currentCounts)
+		return;
+
+	Serial.print(F("Frequency offset: "));
+	Serial.print(frequencyEstimator.getOffsetPpb());
+	Serial.print(F(" ppb over "));
+	Serial.print(frequencyEstimator.getEstimateSeconds());
+	Serial.print(F(" s\n"));
+
+	// Both parts are read by the tick ISR.
+	uint8_t oldSREG = SREG;
+	cli();
+	tick_frac_numerator = scaledCounts % tick_frac_denominator;
+	tick_interval_cycles = scaledCounts / tick_frac_denominator;
+	SREG = oldSREG;
+
+	tick_interval_changed = true;
+	unsaved_parameters = true;
+}
+
+// Returns the offset of a Timer1 timestamp from the nearest local second boundary,
+// in Timer1 counts, in the range -1/2 to +1/2 second.
+int32_t secondPhase(uint32_t timestamp) {
+	uint8_t oldSREG = SREG;
+	cli();
+	uint32_t secondStart = tod_secondStart;
+	SREG = oldSREG;
+
+	int32_t offset = (int32_t)(timestamp - secondStart) % (int32_t)TIMER1_COUNTS_PER_SECOND;
+	if (offset > (int32_t)(TIMER1_COUNTS_PER_SECOND / 2))
+		offset -= TIMER1_COUNTS_PER_SECOND;
+	else if (offset < -(int32_t)(TIMER1_COUNTS_PER_SECOND / 2))
+		offset += TIMER1_COUNTS_PER_SECOND;
+
+	return offset;
+}
+
+void taskTickIntervalChanged() {
+	Serial.print(F("New tick interval: "));
+	Serial.print(tick_interval_cycles);
+	Serial.print(' ');
+	Serial.print(tick_frac_numerator);
+	Serial.print('/');
+	Serial.print(tick_frac_denominator);
+	Serial.print('\n');
+}
+
+
+// Bring the ring up to date. Each layer marks the pixels it changed since the last call,
+// and only those are composed again.
 void updatePixels() {
-	uint32_t color;
+	uint8_t ringMode = display_meter ? RING_MODE_METER : decoder.getMode();
+	if (ringMode != ring_mode) {
+		ring_mode = ringMode;
+		markRing(0, 59);
+	}
 
-	switch (mode) {
+	switch (ringMode) {
 		case MODE_SEEK:
-			// Show incoming samples.
-			for (uint8_t i = 0;  i<60;  i++) {
-				if (sampleIndex == i)
-					color = COLOR_SAMPLE_CURSOR;
-				else {
-					if (sampleBuffer[i])
-						color = COLOR_SAMPLE_ONE;
-					else
-						color = COLOR_SAMPLE_ZERO;
-				}
-				pixels.setPixelColor(i+PIXEL_OFFSET_RING, color);
+			// New samples, and the cursor they moved.
+			if (sampleIndex != ring_sampleIndex) {
+				markRingWrapped(ring_sampleIndex, sampleIndex);
+				ring_sampleIndex = sampleIndex;
 			}
 			break;
 
 		case MODE_SYNC:
-			// Show received data bits.
-			for (uint8_t i = 0;  i<60;  i++) {
-				switch(symbolStream[i]) {
-					case '0':
-						color = COLOR_SYMBOL_ZERO;
-						break;
-					case '1':
-						color = COLOR_SYMBOL_ONE;
-						break;
-					case 'M':
-						color = COLOR_SYMBOL_MARKER;
-						break;
-					default:
-						color = OFF;
-				}
-
-				pixels.setPixelColor(i+PIXEL_OFFSET_RING, color);
+			// Received data bits move along once a second.
+			if (ring_symbolsChanged) {
+				ring_symbolsChanged = false;
+				markRing(0, 59);
 			}
+			break;
 
+		case RING_MODE_METER:
+			// The scores move on every tick.
+			markRing(0, 59);
 			break;
 	}
 
-	if (mode == MODE_SYNC) {
-		// Superimpose sync offset
-		if (bitSync_accumulatedOffset < 0) {
-			for (uint8_t i = 22+bitSync_accumulatedOffset;  i <= 22;  i++)
-				pixels.setPixelColor(i+PIXEL_OFFSET_RING, COLOR_SYNC);
+	updateSyncBar();
+	updateHands();
+
+	for (uint8_t i = 0;  i<60;  i++) {
+		if (ringAnimation.takeDirty(i))
+			markRing(i, i);
+	}
+
+	// Compose the marked pixels.
+	for (uint8_t byte = 0;  byte<sizeof(ring_dirty);  byte++) {
+		uint8_t bits = ring_dirty[byte];
+		if (bits == 0)
+			continue;
+		ring_dirty[byte] = 0;
+
+		for (uint8_t i = byte*8;  bits != 0;  i++, bits >>= 1) {
+			if (!(bits & 0x01))
+				continue;
+
+			uint8_t index = ringIndex(i);
+			if (index != ring_shown[i]) {
+				ring_shown[i] = index;
+				pixels.setPixelColor(i+PIXEL_OFFSET_RING, scaleColor(ringColor(index), pixel_scale));
+			}
 		}
-		else if (bitSync_accumulatedOffset > 0) {
-			for (uint8_t i = 22;  i <= 22+bitSync_accumulatedOffset;  i++)
-				pixels.setPixelColor(i+PIXEL_OFFSET_RING, COLOR_SYNC);
+	}
+
+	if (decoder.getMode() == MODE_SYNC  &&  (tod_fix  ||  tod_estimated)) {
+		// Backlight color
+		setBacklightColor(tod_color);
+		setColonColor(tod_color);
+	}
+}
+
+// Sync offset bar, in sync mode.
+void updateSyncBar() {
+	int8_t from = 0;
+	int8_t to = -1;
+
+	if (ring_mode == MODE_SYNC) {
+		if (bitSync_accumulatedOffset < 0) {
+			from = 22+bitSync_accumulatedOffset;
+			to = 22;
 		}
 		else {
-			pixels.setPixelColor(22+PIXEL_OFFSET_RING, COLOR_SYNC);
+			from = 22;
+			to = 22+bitSync_accumulatedOffset;
 		}
-	
-		if (tod_fix) {
-			// Get local time in AM/PM form
-			int8_t localHours = tod_hours + tzOffsetHours;
-			if (observeDst && tod_isdst) {
-				localHours++;
-			}
-			int8_t localMinutes = tod_minutes + tzOffsetMinutes;
-			if (localMinutes < 0) {
-				localMinutes += 60;
-				localHours--;
-			}
-			if (localMinutes > 59) {
-				localMinutes -= 60;
-				localHours++;
-			}
-			if (localHours < 0) {
-				localHours += 12;
-			}
-			if (localHours > 11) {
-				localHours -= 12;
-			}
+	}
+
+	if (from != ring_syncFrom  ||  to != ring_syncTo) {
+		markRing(ring_syncFrom, ring_syncTo);
+		markRing(from, to);
+		ring_syncFrom = from;
+		ring_syncTo = to;
+	}
+}
+
+// Hour and minute hands, in sync mode once we have the time.
+void updateHands() {
+	int8_t hourPos = -1;
+	int8_t minutePos = -1;
 
-			// Superimpose hour hand
-			uint8_t hourPos = localHours * 5 + (localMinutes / 12) + 21;
-			if (hourPos > 59)
-				hourPos -= 60;
-			pixels.setPixelColor(hourPos+PIXEL_OFFSET_RING, COLOR_HAND_HOUR);
-			if (++hourPos > 59)
-				hourPos -= 60;
-			pixels.setPixelColor(hourPos+PIXEL_OFFSET_RING, COLOR_HAND_HOUR);
-			if (++hourPos > 59)
-				hourPos -= 60;
-			pixels.setPixelColor(hourPos+PIXEL_OFFSET_RING, COLOR_HAND_HOUR);
-
-
-			// Superimpose minute hand
-			uint8_t minutePos = localMinutes + 21;
-			if (minutePos < 0)
-				minutePos += 60;
-			if (minutePos > 59)
-				minutePos -= 60;
-			pixels.setPixelColor(minutePos+PIXEL_OFFSET_RING, COLOR_HAND_MINUTE);
-			if (++minutePos > 59)
-				minutePos -= 60;
-			pixels.setPixelColor(minutePos+PIXEL_OFFSET_RING, COLOR_HAND_MINUTE);
-			if (++minutePos > 59)
-				minutePos -= 60;
-			pixels.setPixelColor(minutePos+PIXEL_OFFSET_RING, COLOR_HAND_MINUTE);
-
-			// Backlight color
-			setBacklightColor(tod_color);
-			setColonColor(tod_color);
+	if (ring_mode == MODE_SYNC  &&  tod_fix) {
+		// Get local time in AM/PM form
+		int8_t localHours = tod_hours + tzOffsetHours;
+		if (observeDst && tod_isdst) {
+			localHours++;
 		}
+		int8_t localMinutes = tod_minutes + tzOffsetMinutes;
+		if (localMinutes < 0) {
+			localMinutes += 60;
+			localHours--;
+		}
+		if (localMinutes > 59) {
+			localMinutes -= 60;
+			localHours++;
+		}
+		if (localHours < 0) {
+			localHours += 12;
+		}
+		if (localHours > 11) {
+			localHours -= 12;
+		}
+
+		hourPos = localHours * 5 + (localMinutes / 12) + 21;
+		if (hourPos > 59)
+			hourPos -= 60;
 
+		minutePos = localMinutes + 21;
+		if (minutePos > 59)
+			minutePos -= 60;
+	}
+
+	if (hourPos != ring_hourPos) {
+		markHand(ring_hourPos);
+		markHand(hourPos);
+		ring_hourPos = hourPos;
+	}
+
+	if (minutePos != ring_minutePos) {
+		markHand(ring_minutePos);
+		markHand(minutePos);
+		ring_minutePos = minutePos;
 	}
 }
 
+// Ring color of a pixel: the animation over the minute hand, over the hour hand, over the
+// sync bar, over the data. The meter replaces all of them.
+uint8_t ringIndex(uint8_t i) {
+	if (ring_mode == RING_MODE_METER)
+		return meterIndex(i);
+
+	uint8_t animation = ringAnimation.getIndex(i);
+	if (animation != 0)
+		return RING_ANIMATION + animation;
+
+	if (onHand(i, ring_minutePos))
+		return RING_HAND_MINUTE;
+	if (onHand(i, ring_hourPos))
+		return RING_HAND_HOUR;
+	if ((int8_t)i >= ring_syncFrom  &&  (int8_t)i <= ring_syncTo)
+		return RING_SYNC;
+
+	if (ring_mode == MODE_SEEK) {
+		// Incoming samples
+		if (i == sampleIndex)
+			return RING_SAMPLE_CURSOR;
+		return sampleBuffer[i] ? RING_SAMPLE_ONE : RING_SAMPLE_ZERO;
+	}
+
+	// Received data bits
+	switch (decoder.getStream()[i]) {
+		case '0':
+			return RING_SYMBOL_ZERO;
+		case '1':
+			return RING_SYMBOL_ONE;
+		case 'M':
+			return RING_SYMBOL_MARKER;
+	}
+	return RING_OFF;
+}
 
-// Invoked at 60Hz by ISR. Samples incoming data bits, and passes them through the discriminators.
-void tick() {
-	// Sample the input - port D bit 7
-	uint8_t input = (PIND & B10000000) >> 7;
-	//uint8_t input = fake_frame.nextBit();
+// Correlator meter: three arcs of 20 pixels from the top of the ring, for the zero, one
+// and marker scoreboards. Each shows the scoreboard history, oldest first, then a bar
+// for the current score. Scores over the threshold show in the peak color.
+uint8_t meterIndex(uint8_t i) {
+	uint8_t position = i < 21 ? i + 39 : i - 21;
+	uint8_t arc = position / 20;
+	uint8_t offset = position - arc * 20;
+
+	ScoreBoard *board = decoder.getScoreBoard(arc);
+	uint8_t color = RING_METER_ZERO + arc * 2;
 
-	// Echo sample to PIN_ECHO, PORTB bit 1
-	if (input) {
-		PORTB |= (1<<PORTB1);
+	uint8_t value;
+	if (offset < ScoreBoard::size) {
+		// History: lit above halfway to the threshold
+		value = board->getSlotValue(ScoreBoard::size-1 - offset);
+		if (value < (METER_FLOOR + decoder.scoreThreshold) / 2)
+			return RING_OFF;
 	}
 	else {
-		PORTB &= ~(1<<PORTB1);
+		// Bar: length in proportion to the score over the floor
+		value = board->getSlotValue(0);
+		uint8_t lit = 0;
+		if (value > METER_FLOOR)
+			lit = (uint16_t)(value - METER_FLOOR) * METER_BAR / (80 - METER_FLOOR);
+		if (offset - ScoreBoard::size >= lit)
+			return RING_OFF;
 	}
 
-	shiftSample(input);
+	return value > decoder.scoreThreshold ? color + 1 : color;
+}
+
+uint32_t ringColor(uint8_t index) {
+	switch (index) {
+		case RING_SAMPLE_ONE:		return COLOR_SAMPLE_ONE;
+		case RING_SAMPLE_ZERO:		return COLOR_SAMPLE_ZERO;
+		case RING_SAMPLE_CURSOR:	return COLOR_SAMPLE_CURSOR;
+		case RING_SYMBOL_ZERO:		return COLOR_SYMBOL_ZERO;
+		case RING_SYMBOL_ONE:		return COLOR_SYMBOL_ONE;
+		case RING_SYMBOL_MARKER:	return COLOR_SYMBOL_MARKER;
+		case RING_SYNC:				return COLOR_SYNC;
+		case RING_HAND_HOUR:		return COLOR_HAND_HOUR;
+		case RING_HAND_MINUTE:		return COLOR_HAND_MINUTE;
+		case RING_METER_ZERO:		return COLOR_METER_ZERO;
+		case RING_METER_ZERO_PEAK:	return COLOR_METER_ZERO_PEAK;
+		case RING_METER_ONE:		return COLOR_METER_ONE;
+		case RING_METER_ONE_PEAK:	return COLOR_METER_ONE_PEAK;
+		case RING_METER_MARKER:		return COLOR_METER_MARKER;
+		case RING_METER_MARKER_PEAK:	return COLOR_METER_MARKER_PEAK;
+	}
+
+	if (index > RING_ANIMATION)
+		return animationColor(index - RING_ANIMATION);
+	return OFF;
+}
 
-	uint8_t score_ZERO = score(PATTERN_ZERO);
-	scoreboard_zero.shiftScore(score_ZERO);
-	uint8_t score_ONE = score(PATTERN_ONE);
-	scoreboard_one.shiftScore(score_ONE);
-	uint8_t score_MARKER = score(PATTERN_MARKER);
-	scoreboard_marker.shiftScore(score_MARKER);
+// A hand is three pixels wide, starting at pos.
+bool onHand(uint8_t i, int8_t pos) {
+	if (pos < 0)
+		return false;
+
+	int8_t offset = (int8_t)i - pos;
+	if (offset < 0)
+		offset += 60;
+	return offset < 3;
+}
+
+void markHand(int8_t pos) {
+	if (pos < 0)
+		return;
+
+	markRingWrapped(pos, pos+2 > 59 ? pos+2-60 : pos+2);
+}
+
+// Mark ring pixels from to to for redrawing. Nothing when from > to.
+void markRing(int8_t from, int8_t to) {
+	if (from < 0)
+		from = 0;
+	if (to > 59)
+		to = 59;
+
+	for (int8_t i = from;  i <= to;  i++)
+		ring_dirty[i >> 3] |= 1 << (i & 0x07);
+}
+
+// Mark ring pixels from to to, going round past 59 if need be.
+void markRingWrapped(uint8_t from, uint8_t to) {
+	if (from <= to)
+		markRing(from, to);
+	else {
+		markRing(from, 59);
+		markRing(0, to);
+	}
+}
+
+
+// Invoked at 60Hz by ISR. Samples incoming data bits, and passes them through the discriminators.
+void tick() {
+	// Sample the input
+	uint8_t input = WwvbPin::read();
+	//uint8_t input = fake_frame.nextBit();
+
+	// Echo sample to PIN_ECHO
+	EchoPin::write(input);
+
+	uint16_t start = TCNT1;
+	decoder.correlate(input);
+	profiler.record(PROFILE_CORRELATE, Profiler::elapsed(start, TCNT1, timer1_periodTop));
 
 	sampleToBuffer(input);
+	if (capture_enabled)
+		captureSample(input);
 
-	pixels.show();
+	scheduler.tick();
 
 	// Hoisted out of MODE_SYNC to keep sync count across all modes
-	bitSync_localTicksSinceSync++;
-	bitSync_localTicksSinceParameterSave++;
-
-	switch (mode) {
-		case MODE_SEEK:
-			bitSeek();
-			break;
+	bitSync_localTicksSinceSync++;
+	bitSync_localTicksSinceParameterSave++;
 
-		case MODE_SYNC:
-			bitSync();
-			break;
-	}
+	start = TCNT1;
+	decodeSymbols();
+	profiler.record(PROFILE_DECODE, Profiler::elapsed(start, TCNT1, timer1_periodTop));
 
-	//flashZero(score_ZERO);
-	//flashOne(score_ONE);
-	//flashMarker(score_MARKER);
+	//flashZero(decoder.getScoreBoard(ZERO)->getSlotValue(0));
+	//flashOne(decoder.getScoreBoard(ONE)->getSlotValue(0));
+	//flashMarker(decoder.getScoreBoard(MARKER)->getSlotValue(0));
 
 	// Update running time
 	tickTime();
+	saveRecoveryState();
+
+	measureVcc();
+
+	// Brightness fades. The pixels follow in the next pixel update.
+	if (brightness.tick())
+		applyBrightness();
 
 	update_pixels_flag = true;
 }
 
+// Pack a sample for capture. Every 60 samples, hand them to the serial task.
+void captureSample(uint8_t input) {
+	if (input)
+		capture_bits[capture_count >> 3] |= _BV(capture_count & 7);
+	if (++capture_count < 60)
+		return;
+
+	capture_frame[0] = capture_sequence & 0xff;
+	capture_frame[1] = capture_sequence >> 8;
+	memcpy(&capture_frame[2], capture_bits, sizeof(capture_bits));
+	memset(capture_bits, 0, sizeof(capture_bits));
+	capture_count = 0;
+	capture_sequence++;
+	capture_flag = true;
+}
+
 // Copy new sample to the buffer, and update the index.
 void sampleToBuffer(uint8_t value) {
 	sampleBuffer[sampleIndex] = value;
@@ -701,163 +1932,169 @@ void sampleToBuffer(uint8_t value) {
 
 // Change the operating mode, updating necessary variables.
 void setMode(uint8_t newMode) {
-	switch (newMode) {
-		case MODE_SEEK:
-			// Reset counters
-			bitSeek_detectedSymbolCount = 0;
-			//setColonColor(COLOR_PINK);
-			break;
-
-		case MODE_SYNC:
-			bitSync_peekCountdown = 60;
-			//bitSync_localTicksSinceSync = 0L;
-			//bitSync_accumulatedOffset = 0;
-			bitSync_parametersSaved = false;
-			bitSync_missedSymbolCount = 0;
-			//setColonColor(COLOR_BLUE);
-			break;
-	}
-
-	mode = newMode;
-	mode_changed = true;
+	bool changed = newMode != decoder.getMode();
+	decoder.setMode(newMode);
+	modeSet(changed);
 }
 
-// Invoked on each tick when in MODE_SEEK. Look for multiple successful symbols.
-// We see a symbol when one of the scoreboards shows a peak value in the center slot. No
-// attempt to detect missing symbols.  When we hit the threshold, switch to MODE_SYNC.
-void bitSeek() {
-	uint8_t peakScore;
-	uint8_t peakIndex;
-
-	char detectedSymbol = 0;
+// The decoder's mode was set: count a change, and have the display follow.
+void modeSet(bool changed) {
+	uint8_t newMode = decoder.getMode();
 
-	// A successful bit has peak in the middle slot. When the peak is elsewhere, ignore it.
-	if (scoreboard_zero.maxOverThreshold(scoreThreshold, &peakScore, &peakIndex)) {
-		if (peakIndex == ScoreBoard::centerIndex) detectedSymbol = '0';
-	}
-	else if (scoreboard_one.maxOverThreshold(scoreThreshold, &peakScore, &peakIndex)) {
-		if (peakIndex == ScoreBoard::centerIndex) detectedSymbol = '1';
-	}
-	else if (scoreboard_marker.maxOverThreshold(scoreThreshold, &peakScore, &peakIndex)) {
-		if (peakIndex == ScoreBoard::centerIndex) detectedSymbol = 'M';
+	if (changed) {
+		if (newMode == MODE_SYNC)
+			metrics_minute.seekToSync++;
+		else
+			metrics_minute.syncToSeek++;
 	}
 
-	// Any symbol seen?
-	if (detectedSymbol != 0) {
-		bitSeek_detectedSymbolCount++;
-		shiftSymbol(detectedSymbol);
-	}
+	if (newMode == MODE_SYNC)
+		bitSync_parametersSaved = false;
 
-	// Enough symbos in a row?
-	if (bitSeek_detectedSymbolCount == bitSeek_detectedSymbolThreshold) {
-		// Commence syncin' proper.
-		setMode(MODE_SYNC);
-	}
+	mode_changed = true;
 }
 
-// Invoked on each tick when in MODE_SYNC. Let 60 (+- offset) ticks elapse, and look for a
-// symbol match. Detect and accumulate drift (when a symbol arrives in an off-center slot)
-// and recalibrate the tick timer interval when a drift threshold is exceeded.
-// If we hit a threshold of missed symbols, switch back to MODE_SEEK.
-void bitSync() {
+// Invoked on each tick, after the correlator. Act on what the decoder found.
+void decodeSymbols() {
+	uint8_t events = decoder.decode();
 
-	if (--bitSync_peekCountdown > 0)
-		return;
+	if (events & WwvbDecoder::EVENT_MODE)
+		modeSet(true);
+	if (events & WwvbDecoder::EVENT_SYMBOL)
+		symbolShifted(events);
+}
 
-	// Look for next symbol.
-	uint8_t peakScore = 0;
-	uint8_t peakIndex = ScoreBoard::centerIndex;
+// A symbol, or a miss, went into the decoder's symbol stream: count it, flag a frame,
+// and in MODE_SYNC, follow the drift its offset shows.
+void symbolShifted(uint8_t events) {
+	char symbol = decoder.getSymbol();
 
-	char detectedSymbol = 0;
+	ring_symbolsChanged = true;
 
-	if (scoreboard_zero.maxOverThreshold(scoreThreshold, &peakScore, &peakIndex)) {
-		detectedSymbol = '0';
-	}
-	else if (scoreboard_one.maxOverThreshold(scoreThreshold, &peakScore, &peakIndex)) {
-		detectedSymbol = '1';
-	}
-	else if (scoreboard_marker.maxOverThreshold(scoreThreshold, &peakScore, &peakIndex)) {
-		detectedSymbol = 'M';
+	if (symbol == '-') {
+		metrics_minute.symbolsMissed++;
+		return;
 	}
-	else {
-		// No symbol seen.
-		shiftSymbol('-');
-		if (++bitSync_missedSymbolCount == bitSync_missedSymbolThreshold) {
-			// Sync lost.
-			setMode(MODE_SEEK);
-			return;
-		}
 
-		//Serial.print("Missed symbol\n");
+	countPeakScore(decoder.getPeakScore());
+	metrics_minute.symbolsDetected++;
+	metrics_minute.marginTotal += decoder.getMargin();
+	if (symbol == 'M'  &&  decoder.getStream()[0] == 'M')
+		metrics_minute.framesAttempted++;
 
-		// Try again next second.
-		bitSync_peekCountdown = 60;
-		return;
-	}
+	//printSymbols();
 
-	// Saw a symbol.
-	shiftSymbol(detectedSymbol);
-	bitSync_missedSymbolCount = 0;
+	if (events & WwvbDecoder::EVENT_FRAME) {
+		valid_frame_flag = true;
+		metrics_minute.framesValid++;
+	}
+	else if (tod_estimated  &&  !tod_fix  &&  decoder.earlyFrameAligned(EARLY_FRAME_MIN_MARGIN)) {
+		early_frame_flag = true;
+	}
 
-	// Are we getting out of sync?  A peak in the middle slot is right on time; a peak
-	// in a different slot means the local oscillator is running fast or slow compared
-	// to the reference.  Accumulate this delta over multiple cycles.  When the delta
-	// reaches a limit, adjust the tick counter interval to compensate.
-	// Positive offset means the local clock is running fast (interval value too small);
-	// negative offset means it's running slow (interval too big).
-	int8_t offset = ScoreBoard::centerIndex - peakIndex;
+	// A symbol seen on the way into MODE_SYNC peaked in the center slot, with no offset.
+	if (decoder.getMode() == MODE_SYNC  &&  !(events & WwvbDecoder::EVENT_MODE))
+		followDrift(decoder.getOffset());
+}
 
+// Are we getting out of sync?  Accumulate the decoder's offsets over multiple cycles.
+// When the delta reaches a limit, adjust the tick counter interval to compensate.
+// Positive offset means the local clock is running fast (interval value too small);
+// negative offset means it's running slow (interval too big).
+void followDrift(int8_t offset) {
 	bitSync_accumulatedOffset += offset;
+	metrics_minute.phaseCorrection += offset;
+	metrics_minute.phaseCorrectionAbs += offset < 0 ? -offset : offset;
 
 	if (offset != 0) {
-		Serial.print("Accumulated offset: ");
+		Serial.print(F("Accumulated offset: "));
 		Serial.print(bitSync_accumulatedOffset);
-		Serial.print(" , ticks since sync: ");
+		Serial.print(F(" , ticks since sync: "));
 		Serial.print(bitSync_localTicksSinceSync);
 		Serial.print('\n');
 	}
 
-	// Next time, peek when next symbol should be centered again.
-	bitSync_peekCountdown = 60 + offset;
+	// The edge-timed phase resolves drift far finer than the slot offset, so it sets the
+	// tick interval when it has one; the slot offsets are the fallback.
+	if (edge_phaseFresh) {
+		edge_phaseFresh = false;
+		if (trackEdgePhase(edge_phaseOffset))
+			return;
+	}
 
-	//Serial.print(detectedSymbol);
-	//Serial.print("    Sync offset: ");
+	//Serial.print(decoder.getSymbol());
+	//Serial.print(F("    Sync offset: "));
 	//if (offset >= 0)
 	//	Serial.print(' ');
 	//Serial.print(offset);
-	//Serial.print("    Accumulated offset: ");
+	//Serial.print(F("    Accumulated offset: "));
 	//if (bitSync_accumulatedOffset >= 0)
 	//	Serial.print(' ');
 	//Serial.print(bitSync_accumulatedOffset);
-	//Serial.print("    Local ticks: ");
+	//Serial.print(F("    Local ticks: "));
 	//Serial.print(bitSync_localTicksSinceSync);
 	//Serial.print('\n');
 
 	// Have we accumulated enough delta to adjust?
 	if (bitSync_accumulatedOffset < -15  ||  bitSync_accumulatedOffset > 15) {
-		// Only adjust if local ticks is large enough -- otherwise we overreact to noise
+		// Only adjust if local ticks is large enough -- otherwise we overreact to noise.
+		// Once the frequency estimator is locked, it sets the interval instead.
 		if (bitSync_localTicksSinceSync > 1000) {
-			adjustTickInterval(bitSync_localTicksSinceSync, bitSync_localTicksSinceSync - bitSync_accumulatedOffset);
+			if (!frequencyLocked())
+				adjustTickInterval(bitSync_localTicksSinceSync, bitSync_localTicksSinceSync - bitSync_accumulatedOffset);
 			bitSync_localTicksSinceSync = 0;
 			bitSync_accumulatedOffset = 0;
+			bitSync_phaseValid = false;
 		}
 	}
 }
 
+// Measure drift from successive edge-timed phases, and adjust the tick interval once it
+// passes EDGE_DRIFT_THRESHOLD over at least 1000 ticks. Returns true if it adjusted. A
+// phase that grows means the local second is starting earlier: the clock is fast.
+bool trackEdgePhase(int32_t phase) {
+	int32_t step = phase - bitSync_phaseLast;
+	uint32_t elapsedTicks = bitSync_localTicksSinceSync - bitSync_phaseReferenceTicks;
+
+	if (!bitSync_phaseValid  ||  step > EDGE_PHASE_STEP_LIMIT  ||  step < -EDGE_PHASE_STEP_LIMIT
+			||  elapsedTicks > EDGE_DRIFT_MAX_TICKS) {
+		bitSync_phaseValid = true;
+		bitSync_phaseReference = phase;
+		bitSync_phaseLast = phase;
+		bitSync_phaseReferenceTicks = bitSync_localTicksSinceSync;
+		return false;
+	}
+	bitSync_phaseLast = phase;
+
+	int32_t drift = phase - bitSync_phaseReference;
+	if (elapsedTicks <= 1000  ||  (drift < EDGE_DRIFT_THRESHOLD  &&  drift > -EDGE_DRIFT_THRESHOLD))
+		return false;
+
+	// Once the frequency estimator is locked, it sets the interval instead.
+	if (!frequencyLocked()) {
+		uint32_t elapsedCounts = elapsedTicks * (TIMER1_COUNTS_PER_SECOND / 60);
+		adjustTickInterval(elapsedCounts, elapsedCounts - drift);
+	}
+	bitSync_localTicksSinceSync = 0;
+	bitSync_accumulatedOffset = 0;
+	bitSync_phaseValid = false;
+	return true;
+}
+
 
 // Udpate the tick interval to compensate for counting localTicks while
 // appearing to count apparentTicks.  Both parameters should be near each
 // other (+-k, for small k).
 void adjustTickInterval(unsigned long localTicks, unsigned long apparentTicks) {
 
-	Serial.print("Adjusting tick interval\n  Local ticks: ");
+	Serial.print(F("Adjusting tick interval\n  Local ticks: "));
 	Serial.print(localTicks);
-	Serial.print("\n  Apparent ticks: ");
+	Serial.print(F("\n  Apparent ticks: "));
 	Serial.print(apparentTicks);
 
 	// Combine whole cycles and fraction into scaled integer
 	unsigned long scaledCounts = (unsigned long)tick_interval_cycles * tick_frac_denominator + tick_frac_numerator;
-	Serial.print("\n  Current counts: ");
+	Serial.print(F("\n  Current counts: "));
 	Serial.print(scaledCounts);
 
 	unsigned long updatedCounts;
@@ -866,11 +2103,11 @@ void adjustTickInterval(unsigned long localTicks, unsigned long apparentTicks) {
 	// Adjust halfway between old and new. A form of low-pass filtering.
 	unsigned long filteredCounts = (updatedCounts + scaledCounts) >> 1;
 
-	Serial.print("\nUpdated counts: ");
+	Serial.print(F("\nUpdated counts: "));
 	Serial.print(updatedCounts);
-	Serial.print("\nFiltered counts: ");
+	Serial.print(F("\nFiltered counts: "));
 	Serial.print(filteredCounts);	
-	Serial.print("\n  Difference: ");
+	Serial.print(F("\n  Difference: "));
 
 	long difference = filteredCounts - scaledCounts;
 	Serial.print(difference);
@@ -910,114 +2147,15 @@ uint32_t muldiv(uint32_t a, uint32_t b, uint32_t c) {
 	return q;
 }
 
-void shiftSymbol(char newSymbol) {
-	uint8_t score = 0;
-
-	char outgoingSymbol = symbolStream[0];
-
-	// Single loop for shifting and scoring. Only check that positions that should have
-	// marker symbol have them, and that non-marker positions do not.
-
-	// When markerPos = 0, we're shifting into a marker position. It gets reset to 9
-	// after processing a marker position.
-	uint8_t markerPosCountdown = 10;
-	
-	for (uint8_t i=0;  i<59;  i++) {
-		markerPosCountdown--;
-		char symbol = symbolStream[i+1];
-		symbolStream[i] = symbol;
-		if (markerPosCountdown == 0) {
-			// Should be a marker symbol.
-			if (symbol == 'M')
-				score++;
-			markerPosCountdown = 10;
-		}
-		else {
-			// Should be a 1 or 0.
-			if (symbol == '0'  ||  symbol == '1')
-				score++;
-		}
-	}
-
-	// Position 0 is a marker when aligned
-	if (symbolStream[0] == 'M')
-		score++;	
-
-	symbolStream[59] = newSymbol;
-	if (newSymbol == 'M' )
-		score++;
-
-	//printSymbols();
-
-	if (score == 60) {
-		valid_frame_flag = true;
-	}
+void countPeakScore(uint8_t peakScore) {
+	uint8_t bucket = peakScore / 10;
+	if (bucket >= METRIC_SCORE_BUCKETS)
+		bucket = METRIC_SCORE_BUCKETS - 1;
+	metrics_minute.peakScores[bucket]++;
 }
 
-
-void decodeTimeOfDay(uint8_t ticksDelta) {
-
-	// Decode the symbol word in the buffer, and set the time. Adjust by the tickDelta value.
-	uint8_t minutes = 0;
-	uint8_t hours = 0;
-	uint16_t daynum = 0;
-	uint16_t year = 2000;
-	bool leapYear = false;
-	uint8_t dst = 0;
-
-	// Symbols are stored as '0' and '1' characters; LSB for 0 symbol is 0, and LSB for 1 symbol is 1.
-	if (symbolStream[1] & 0x01) minutes += 40;
-	if (symbolStream[2] & 0x01) minutes += 20;
-	if (symbolStream[3] & 0x01) minutes += 10;
-	if (symbolStream[5] & 0x01) minutes += 8;
-	if (symbolStream[6] & 0x01) minutes += 4;
-	if (symbolStream[7] & 0x01) minutes += 2;
-	if (symbolStream[8] & 0x01) minutes += 1;
-
-	if (symbolStream[12] & 0x01) hours += 20;
-	if (symbolStream[13] & 0x01) hours += 10;
-	if (symbolStream[15] & 0x01) hours += 8;
-	if (symbolStream[16] & 0x01) hours += 4;
-	if (symbolStream[17] & 0x01) hours += 2;
-	if (symbolStream[18] & 0x01) hours += 1;
-
-	if (symbolStream[22] & 0x01) daynum += 200;
-	if (symbolStream[23] & 0x01) daynum += 100;
-	if (symbolStream[25] & 0x01) daynum += 80;
-	if (symbolStream[26] & 0x01) daynum += 40;
-	if (symbolStream[27] & 0x01) daynum += 20;
-	if (symbolStream[28] & 0x01) daynum += 10;
-	if (symbolStream[30] & 0x01) daynum += 8;
-	if (symbolStream[31] & 0x01) daynum += 4;
-	if (symbolStream[32] & 0x01) daynum += 2;
-	if (symbolStream[33] & 0x01) daynum += 1;
-			
-	if (symbolStream[45] & 0x01) year += 80;
-	if (symbolStream[46] & 0x01) year += 40;
-	if (symbolStream[47] & 0x01) year += 20;
-	if (symbolStream[48] & 0x01) year += 10;
-	if (symbolStream[50] & 0x01) year += 8;
-	if (symbolStream[51] & 0x01) year += 4;
-	if (symbolStream[52] & 0x01) year += 2;
-	if (symbolStream[53] & 0x01) year += 1;
-
-	if (symbolStream[55] & 0x01) leapYear = true;
-
-	// 2-bit DST code
-	if (symbolStream[57] & 0x01) dst = 2;
-	if (symbolStream[58] & 0x01) dst += 1;
-
- 	// Update time of day. Decoded time is that at the start of the current frame transmission,
-	// so the current minute is one later. Seconds value is implicitly 0.
-	tod_ticks = ticksDelta;
-	tod_seconds = 0;
-	tod_minutes = minutes + 1;
-	tod_hours = hours;
-	tod_day = daynum;
-	tod_year = year;
-	tod_isleapyear = leapYear;
-
-	// Adjust for overflow.
+// Carry the ticks, seconds, minutes and hours of the time of day into the larger units.
+void normalizeTimeOfDay() {
 	while (tod_ticks > 59) {
 		tod_ticks -= 60;
 		tod_seconds++;
@@ -1034,19 +2172,78 @@ void decodeTimeOfDay(uint8_t ticksDelta) {
 		tod_hours -= 24;
 		tod_day++;
 	}
-	if (leapYear) {
+	if (tod_isleapyear) {
 		if (tod_day > 366) {
 			tod_day -= 366;
 			tod_year++;
-		}
-		else if (tod_day > 365) {
-			tod_day -= 365;
-			tod_year++;
+			tod_isleapyear = isLeapYear(tod_year);
 		}
 	}
+	else if (tod_day > 365) {
+		tod_day -= 365;
+		tod_year++;
+		tod_isleapyear = isLeapYear(tod_year);
+	}
+}
+
+// Set the time of day from the first 20 symbols of a frame, at the end of the stream,
+// and the saved date. Returns false, leaving the time alone, if the hours and minutes
+// are not within WARM_START_WINDOW_MINUTES after the saved time.
+bool decodeEarlyFrame(uint8_t ticksDelta) {
+	const char *frame = decoder.getStream() + WwvbDecoder::earlyFrameStart;
+	uint8_t minutes = WwvbDecoder::frameMinutes(frame);
+	uint8_t hours = WwvbDecoder::frameHours(frame);
+
+	if (minutes > 59  ||  hours > 23)
+		return false;
+
+	int16_t decoded = hours * 60 + minutes;
+	int16_t saved = warm_saved.hours * 60 + warm_saved.minutes;
+	int16_t elapsed = decoded - saved;
+	if (elapsed < 0)
+		elapsed += 24 * 60;
+	if (elapsed > (int16_t) WARM_START_WINDOW_MINUTES)
+		return false;
+
+	// The frame started 20 seconds ago, at the decoded minute.
+	tod_ticks = ticksDelta;
+	tod_seconds = 20;
+	tod_minutes = minutes;
+	tod_hours = hours;
+	tod_day = warm_saved.day;
+	tod_year = 2000 + warm_saved.year;
+	tod_isleapyear = warm_saved.timeFlags & SAVED_TIME_LEAP_YEAR;
+	tod_isdst = warm_saved.timeFlags & SAVED_TIME_DST;
+
+	// Past midnight since the save?
+	if (decoded < saved)
+		tod_day++;
+
+	normalizeTimeOfDay();
+	return true;
+}
+
+
+void decodeTimeOfDay(uint8_t ticksDelta) {
+
+	// Decode the symbol word in the buffer, and set the time. Adjust by the tickDelta value.
+	FrameTime frame;
+	decoder.readFrame(&frame);
+
+ 	// Update time of day. Decoded time is that at the start of the current frame transmission,
+	// so the current minute is one later. Seconds value is implicitly 0.
+	tod_ticks = ticksDelta;
+	tod_seconds = 0;
+	tod_minutes = frame.minutes + 1;
+	tod_hours = frame.hours;
+	tod_day = frame.day;
+	tod_year = frame.year;
+	tod_isleapyear = frame.leapYear;
+
+	normalizeTimeOfDay();
 
 	// Daylight Saving Time in effect?
-	switch (dst) {
+	switch (frame.dst) {
 		case 0:
 			// DST not in effect
 			tod_isdst = false;
@@ -1073,30 +2270,45 @@ void decodeTimeOfDay(uint8_t ticksDelta) {
 // Sets color of tube backlight pixels
 void setBacklightColor(uint32_t color)
 {
+	backlight_color = color;
+	backlight_rainbow = false;
+	showBacklight();
+}
+
+// Restore backlights to rainbow pattern
+void setBacklightRainbow()
+{
+	backlight_rainbow = true;
+	showBacklight();
+}
+
+// Draw the backlight pixels at the current brightness.
+void showBacklight() {
+	if (backlight_rainbow) {
+		pixels.setPixelColor(0+PIXEL_OFFSET_BACKLIGHT, scaleColor(COLOR_RED, pixel_scale));
+		pixels.setPixelColor(1+PIXEL_OFFSET_BACKLIGHT, scaleColor(COLOR_ORANGE, pixel_scale));
+		pixels.setPixelColor(4+PIXEL_OFFSET_BACKLIGHT, scaleColor(COLOR_YELLOW, pixel_scale));
+		pixels.setPixelColor(5+PIXEL_OFFSET_BACKLIGHT, scaleColor(COLOR_GREEN, pixel_scale));
+		pixels.setPixelColor(8+PIXEL_OFFSET_BACKLIGHT, scaleColor(COLOR_BLUE, pixel_scale));
+		pixels.setPixelColor(9+PIXEL_OFFSET_BACKLIGHT, scaleColor(COLOR_PURPLE, pixel_scale));
+	}
+	else {
+		uint32_t color = scaleColor(backlight_color, pixel_scale);
 		pixels.setPixelColor(0+PIXEL_OFFSET_BACKLIGHT, color);
 		pixels.setPixelColor(1+PIXEL_OFFSET_BACKLIGHT, color);
 		pixels.setPixelColor(4+PIXEL_OFFSET_BACKLIGHT, color);
 		pixels.setPixelColor(5+PIXEL_OFFSET_BACKLIGHT, color);
 		pixels.setPixelColor(8+PIXEL_OFFSET_BACKLIGHT, color);
 		pixels.setPixelColor(9+PIXEL_OFFSET_BACKLIGHT, color);
+	}
 }
 
-// Restore backlights to rainbow pattern
-void setBacklightRainbow()
-{
-			pixels.setPixelColor(0+PIXEL_OFFSET_BACKLIGHT, COLOR_RED);
-			pixels.setPixelColor(1+PIXEL_OFFSET_BACKLIGHT, COLOR_ORANGE);
-			pixels.setPixelColor(4+PIXEL_OFFSET_BACKLIGHT, COLOR_YELLOW);
-			pixels.setPixelColor(5+PIXEL_OFFSET_BACKLIGHT, COLOR_GREEN);
-			pixels.setPixelColor(8+PIXEL_OFFSET_BACKLIGHT, COLOR_BLUE);
-			pixels.setPixelColor(9+PIXEL_OFFSET_BACKLIGHT, COLOR_PURPLE);
-}
 
 int8_t backlightHold = 0;
 // Indicate that we have detected a ZERO symbol.
 void flashZero(int score) {
 
-	if (score > scoreThreshold) {
+	if (score > decoder.scoreThreshold) {
 		backlightHold = 60;
 		setBacklightColor(COLOR_SAMPLE_ZERO);
 	}
@@ -1112,7 +2324,7 @@ void flashZero(int score) {
 // Indicate that we have detected a ONE symbol.
 void flashOne(int score) {
 
-	if (score > scoreThreshold) {
+	if (score > decoder.scoreThreshold) {
 		backlightHold = 60;
 		setBacklightColor(COLOR_SYMBOL_ONE);
 	}
@@ -1128,7 +2340,7 @@ void flashOne(int score) {
 // Indicate that we have detected a MARKER symbol.
 void flashMarker(int score) {
 
-	if (score > scoreThreshold) {
+	if (score > decoder.scoreThreshold) {
 		backlightHold = 60;
 		setBacklightColor(COLOR_SYMBOL_MARKER);
 	}
@@ -1141,129 +2353,28 @@ void flashMarker(int score) {
 	}
 }
 
-// Shifts in a new bit sample into the array. The new bit is the LSB of the passed value.
-void shiftSample(uint8_t value) {
-
-	// Assembly language for fastness.
-	asm volatile(
-
-		// Constraints at end of asm block:
-		// Output constraints:
-		// "=r" (value)		Contstraint 0: Variable "value" will be written. Use a register for it.
-		// Input constraints
-		// "e" (samples)	Constraint 1: Set one of X, Y, or Z base register to address of "samples".
-		//					Refer to it with %a1. (This code will be inserted at top of the asm block.)
-		// "0" (value)		Constraint 2: Varialbe "value" will be input to an operation. Its
-		//					location must match that used for constraint 0 (same register). Refer
-		//					to it as %2.
-
-		// Shift LSB of value into Carry flag
-		"lsr %2 \n\t"
-		
-		// Unrolled loop to shift 10 bytes.  __tmp_reg__ will be replaced with a register
-		// that can be used freely, without saving or restoring its value. %a1 refers to the
-		// pointer register selected by the compiler.
-		"ld __tmp_reg__, %a1 \n\t"
-		"rol __tmp_reg__ \n\t"
-		"st %a1+, __tmp_reg__ \n\t"
-
-		"ld __tmp_reg__, %a1 \n\t"
-		"rol __tmp_reg__ \n\t"
-		"st %a1+, __tmp_reg__ \n\t"
-
-		"ld __tmp_reg__, %a1 \n\t"
-		"rol __tmp_reg__ \n\t"
-		"st %a1+, __tmp_reg__ \n\t"
-
-		"ld __tmp_reg__, %a1 \n\t"
-		"rol __tmp_reg__ \n\t"
-		"st %a1+, __tmp_reg__ \n\t"
-
-		"ld __tmp_reg__, %a1 \n\t"
-		"rol __tmp_reg__ \n\t"
-		"st %a1+, __tmp_reg__ \n\t"
-
-		"ld __tmp_reg__, %a1 \n\t"
-		"rol __tmp_reg__ \n\t"
-		"st %a1+, __tmp_reg__ \n\t"
-
-		"ld __tmp_reg__, %a1 \n\t"
-		"rol __tmp_reg__ \n\t"
-		"st %a1+, __tmp_reg__ \n\t"
-
-		"ld __tmp_reg__, %a1 \n\t"
-		"rol __tmp_reg__ \n\t"
-		"st %a1+, __tmp_reg__ \n\t"
-
-		"ld __tmp_reg__, %a1 \n\t"
-		"rol __tmp_reg__ \n\t"
-		"st %a1+, __tmp_reg__ \n\t"
-
-		"ld __tmp_reg__, %a1 \n\t"
-		"rol __tmp_reg__ \n\t"
-		"st %a1+, __tmp_reg__ \n\t"
-
-		// See above for constraint explanation
-		: "=r" (value) : "e" (samples), "0" (value)
-	);
-}
-
-
-// Array, indexed from 0..255, where each byte contains the number of 1 bits
-// in the corresponding index. Used by score function to sum the number of
-// matching bits in pattern comparisons.
-uint8_t arity[256] = {
-	0,	1,	1,	2,	1,	2,	2,	3,	1,	2,	2,	3,	2,	3,	3,	4,		// 0x00..0x0f
-	1,	2,	2,	3,	2,	3,	3,	4,	2,	3,	3,	4,	3,	4,	4,	5,		// 0x10..0x1f (+1)
-	1,	2,	2,	3,	2,	3,	3,	4,	2,	3,	3,	4,	3,	4,	4,	5,		// 0x20..0x2f (+1)
-	2,	3,	3,	4,	3,	4,	4,	5,	3,	4,	4,	5,	4,	5,	5,	6,		// 0x30..0x3f (+2)
-
-	1,	2,	2,	3,	2,	3,	3,	4,	2,	3,	3,	4,	3,	4,	4,	5,		// 0x40..0x4f (+1)
-	2,	3,	3,	4,	3,	4,	4,	5,	3,	4,	4,	5,	4,	5,	5,	6,		// 0x50..0x5f (+2)
-	2,	3,	3,	4,	3,	4,	4,	5,	3,	4,	4,	5,	4,	5,	5,	6,		// 0x60..0x6f (+2)
-	3,	4,	4,	5,	4,	5,	5,	6,	4,	5,	5,	6,	5,	6,	6,	7,		// 0x70..0x7f (+3)
-
-	1,	2,	2,	3,	2,	3,	3,	4,	2,	3,	3,	4,	3,	4,	4,	5,		// 0x80..0x8f (+1)
-	2,	3,	3,	4,	3,	4,	4,	5,	3,	4,	4,	5,	4,	5,	5,	6,		// 0x90..0x9f (+2)
-	2,	3,	3,	4,	3,	4,	4,	5,	3,	4,	4,	5,	4,	5,	5,	6,		// 0xa0..0xaf (+2)
-	3,	4,	4,	5,	4,	5,	5,	6,	4,	5,	5,	6,	5,	6,	6,	7,		// 0xb0..0xbf (+3)
-
-	2,	3,	3,	4,	3,	4,	4,	5,	3,	4,	4,	5,	4,	5,	5,	6,		// 0xc0..0xcf (+2)
-	3,	4,	4,	5,	4,	5,	5,	6,	4,	5,	5,	6,	5,	6,	6,	7,		// 0xd0..0xdf (+3)
-	3,	4,	4,	5,	4,	5,	5,	6,	4,	5,	5,	6,	5,	6,	6,	7,		// 0xe0..0xef (+3)
-	4,	5,	5,	6,	5,	6,	6,	7,	5,	6,	6,	7,	6,	7,	7,	8,		// 0xf0..0xff (+4)
-};
-
-
-// Score the sample array bits against the supplied pattern. Result
-// is number of matching bits between them.
-int score(uint8_t *pattern) {
-
-	int score = 0;
-	for (int i=0; i<10; i++) {
-		// Compute matching bits: XOR pattern and samples, and complement
-		uint8_t matchingBits = ~(samples[i] ^ pattern[i]);
-		score += arity[matchingBits];
-	}
-
-	return score;
-}
-
 // Increment the time of day.  Sets tod_secondChanged when tod_seconds changes.
 void tickTime() {
 
 	tod_ticks++;
 
-	// Blank time on the half-second when we haven't got a time fix
-	if (!tod_fix && tod_ticks > 45) {
+	// Blank time on the half-second when we haven't got a time fix, or an estimate
+	if (!tod_fix && !tod_estimated && tod_ticks > 45) {
 		resetNixies();
 		updateNixies();
 	}
 
+	if (cathodeExercise_active)
+		cathodeExerciseTick();
+
 	if (tod_ticks < 60)
 		return;
 
+	// An exercise never runs into the next second.
+	cathodeExercise_active = false;
+
 	tod_secondChanged = true;
+	tod_secondStart = timer1_periodStart;
 
 	tod_ticks = 0;
 	tod_seconds++;
@@ -1300,15 +2411,23 @@ void tickTime() {
 	unsigned int year_length = 365;
 	if (tod_isleapyear)
 		year_length = 366;
-	if (tod_day < year_length)
+	if (tod_day <= year_length)
 		return;
 
 	tod_day = 1;
 	tod_year++;
+	tod_isleapyear = isLeapYear(tod_year);
 
 }
 
 void setColonColor(uint32_t color) {
+	colon_color = color;
+	showColon();
+}
+
+// Draw the colon pixels at the current brightness.
+void showColon() {
+	uint32_t color = scaleColor(colon_color, pixel_scale);
 	pixels.setPixelColor(2+PIXEL_OFFSET_BACKLIGHT, color);
 	pixels.setPixelColor(3+PIXEL_OFFSET_BACKLIGHT, color);
 	pixels.setPixelColor(6+PIXEL_OFFSET_BACKLIGHT, color);
@@ -1319,13 +2438,12 @@ void setColonColor(uint32_t color) {
 // Set the current time of day on the hours, minutes, and seconds digits, 
 // using UTC.
 void updateTimeOfDayUtc() {
-	setHours(tod_hours);
-	setMinutes(tod_minutes);
-	setSeconds(tod_seconds);
+	composeNixies(nixieData, tod_hours, tod_minutes, tod_seconds);
 }
 
-// Set current local time of day on the hours, minutes and seconds digits.
-void updateTimeOfDayLocal(int8_t hoursOffset, int8_t minutesOffset, bool AMPM) {
+// Set current local time of day on the hours, minutes and seconds digits, or
+// the local date when showDate is set.
+void updateTimeOfDayLocal(int8_t hoursOffset, int8_t minutesOffset, bool AMPM, bool showDate) {
 
 	int16_t local_day = tod_day;
 	int8_t local_hours = tod_hours + hoursOffset;
@@ -1350,16 +2468,26 @@ void updateTimeOfDayLocal(int8_t hoursOffset, int8_t minutesOffset, bool AMPM) {
 		local_day--;
 	}
 
-	int days_in_year = 365;
-	if (tod_isleapyear)
-		days_in_year = 366;
-	if (local_day > days_in_year) {
-		local_day -= days_in_year;
+	// The offset can carry the date into the year before or after the UTC one, whose
+	// length and leap flag are its own.
+	bool local_isleapyear = tod_isleapyear;
+	if (local_day > (local_isleapyear ? 366 : 365)) {
+		local_day -= local_isleapyear ? 366 : 365;
 		local_year++;
+		local_isleapyear = isLeapYear(local_year);
 	}
 	else if (local_day < 1) {
-		local_day += days_in_year;
 		local_year--;
+		local_isleapyear = isLeapYear(local_year);
+		local_day += local_isleapyear ? 366 : 365;
+	}
+
+	if (showDate) {
+		uint8_t month;
+		uint8_t day;
+		dayOfYearToDate(local_day, local_isleapyear, &month, &day);
+		composeNixies(nixieData, month, day, dayOfWeek(local_year, local_day) + 1);
+		return;
 	}
 
 	// Display in 12 hour format?
@@ -1370,200 +2498,148 @@ void updateTimeOfDayLocal(int8_t hoursOffset, int8_t minutesOffset, bool AMPM) {
 			local_hours = 12;
 	}
 
-	setHours(local_hours);
-	setMinutes(local_minutes);
-	setSeconds(tod_seconds);
+	composeNixies(nixieData, local_hours, local_minutes, tod_seconds);
 }
 
-// Send current nixie data
-void updateNixies() {
-	digitalWrite(PIN_RCK, LOW);
-	SPI.beginTransaction(SPISettings(1000000, MSBFIRST, SPI_MODE0));
-	for (int i=0; i<6; i++) {
-		SPI.transfer(nixieData[i]);
-	}
-	SPI.endTransaction();
-	digitalWrite(PIN_RCK, HIGH);
+// Nixie frame, duty cycle or fade step changed: build the engine's next schedule.
+void taskBuildNixies() {
+	nixieEngine.build();
 }
 
-// Clear all nixie digits
-void resetNixies() {
-	for (int i=0; i<6; i++) {
-		nixieData[i] = 0;
-	}
+// Show current nixie data, crossfading changed digits.
+void updateNixies() {
+	nixieEngine.setFrame(nixieData, nixieCrossfade);
 }
 
-// Set the value displayed on the seconds digits. No range check performed.
-// 0 <= value <= 60
-void setSeconds(int value) {
-	int units;
-	int tens;
-
-	// Blank all seconds segments
-	nixieData[5] = 0;
-	nixieData[4] = 0;
-	nixieData[3] &= B11111110;
+// Show a nixie frame at once, without a fade.
+void showNixieFrame(const volatile uint8_t *frame) {
+	nixieEngine.setFrame(frame, false);
+}
 
-    tens = value / 10;
-	units = value % 10;
+// Send a nixie frame to the tube drivers. The frame is queued for the SPI interrupt, which
+// shifts it out and raises RCK after the last byte, so this returns immediately. The frame
+// is copied when its transfer starts.
+void transmitNixieFrame(const volatile uint8_t *frame) {
+	uint8_t oldSREG = SREG;
+	cli();
 
-	if (units < 8) {
-		nixieData[5] = (1 << units);
-	}
-	else {
-		nixieData[4] |= (1 << (units-8));
+	if (nixieTxBusy) {
+		nixieTxPendingFrame = frame;
+		nixieTxPending = true;
 	}
+	else
+		startNixieTransfer(frame);
 
-	if (tens < 6) {
-		nixieData[4] |= (1 << (tens+2));
-	}
-	else {
-		nixieData[3] |= B00000001;
-	}
+	SREG = oldSREG;
 }
 
-// Set the value displayed on the minutes digits. No range check performed.
-// 0 <= value <= 59
-void setMinutes(int value) {
-	int units;
-	int tens;
-
-	// Blank all minutes segments
-	nixieData[3] &= B00000001;
-	nixieData[2] = 0;
-	nixieData[1] &= B11111110;
-
-	tens = value / 10;
-	units = value % 10;
-
-	if (units < 7) {
-		nixieData[3] |= (1 << (units+1));
-	}
-	else {
-		nixieData[2] |= (1 << (units-7));
+// Copy a frame and start shifting it out. Call with interrupts disabled.
+void startNixieTransfer(const volatile uint8_t *frame) {
+	for (uint8_t i=0; i<6; i++) {
+		nixieTxFrame[i] = frame[i];
 	}
 
-	if (tens < 5) {
-		nixieData[2] |= (1 << (tens+3));
-	}
-	else {
-		nixieData[1] |= 1;
-	}
+	nixieTxBusy = true;
+	RckPin::low();
+	nixieTxIndex = 1;
+	SPDR = nixieTxFrame[0];
 }
 
-// Set the value displayed on the hours digits. No range check performed.
-// 0 <= value <= 23
-void setHours(int value) {
-	int tens = value / 10;
-	int units = value % 10;
-
-	// Blank all hours segments
-	nixieData[1] &= B00000001;
-	nixieData[0] = 0;
+// Invoked by tickTime() on each tick of a cathode exercise second. Shows each step of
+// the planned exercise in turn, then restores the time.
+void cathodeExerciseTick() {
+	if (tod_ticks < CATHODE_EXERCISE_FIRST_TICK)
+		return;
 
-	if (units < 7) {
-		nixieData[1] |= (1 << (units+1));
-	}
-	else {
-		nixieData[0] |= (1 << (units-7));
+	uint8_t exerciseTicks = tod_ticks - CATHODE_EXERCISE_FIRST_TICK;
+	if (exerciseTicks >= CathodeCare::exerciseSteps * CATHODE_EXERCISE_STEP_TICKS) {
+		cathodeExercise_active = false;
+		updateNixies();
+		return;
 	}
 
-	// Suppress leading zero
-	if (tens > 0) {
-		nixieData[0] |= (1 << (tens+3));
+	if (exerciseTicks % CATHODE_EXERCISE_STEP_TICKS == 0) {
+		cathodeCare.exerciseFrame(exerciseTicks / CATHODE_EXERCISE_STEP_TICKS, cathodeExerciseFrame);
+		showNixieFrame(cathodeExerciseFrame);
 	}
 }
 
-void setTubePwm(uint8_t value) {
-	OCR2B = value;
+// Clear all nixie digits
+void resetNixies() {
+	for (int i=0; i<6; i++) {
+		nixieData[i] = 0;
+	}
 }
 
-// Scale 0 - 479 to 0 - 255
-uint8_t scale480(uint16_t val)
-{
-	// mutlply by 256/480 = 8/15
-	// 1/15 = 0.0001000100010001...
-	// 8/15 = 0.10001000100010001...
-	uint32_t longVal = val;
-	uint32_t prod = longVal + (longVal << 4) + (longVal << 8) + (longVal << 12) + (longVal << 16);
-	uint8_t result = prod >> 17;
-
-	//Serial.print("Mapping ");
-	//Serial.print(val);
-	//Serial.print(": prod=");
-	//Serial.print(prod);
-	//Serial.print(". Result=");
-	//Serial.println(result);
-
-	return result;
+// Set the brightness of all tubes, 0 - 255.
+void setTubePwm(uint8_t value) {
+	OCR2B = ((uint16_t)value * (TUBE_PWM_MAX + 1)) >> 8;
 }
 
-// Map hour and minute into a color
+// Map hour and minute into a color: midnight to 8:00am, red to blue; to 4:00pm, blue
+// to green; to midnight, green to red.
 uint32_t minuteColor(uint8_t hours, uint8_t minutes) {
-	uint16_t min = hours * 60 + minutes;
-	uint8_t q;
-
-	if (min < 480) {
-		// Midnight to 8:00am
-		// Red to blue
-		q = scale480(min);
-		return pixels.Color(255-q, 0, q);
-	}
-
-	min -= 480;
-	if (min < 480) {
-		// 8:00am to 4:00pm
-		// Blue to green
-		q = scale480(min);
-		return pixels.Color(0, q, 255-q);
-	}
-
-	min -= 480;
-	// 4:00pm to midnight
-	// Green to red
-	q = scale480(min);
-	return pixels.Color(q, 255-q, 0);
+	uint16_t index = (hours * 60 + minutes) / MINUTE_COLOR_STEP;
+	return tableColor(MINUTE_COLORS[index]);
 }
 
 // Input a value 1 to 366 to get a color value.
 // The colours are a transition r - g - b - back to r.
 uint32_t dayColor(uint16_t n) {
-  uint16_t q;
-  n = 366 - n;
-
-  if(n < 122) {
-	  q = n * 2;
-    return pixels.Color(255 - q, 0, q * 2);
-  }
-  if(n < 244) {
-    n -= 122;
-	q = n * 2;
-    return pixels.Color(0, q * 2, 255 - q * 2);
-  }
-  n -= 244;
-  q = n * 2;
-  return pixels.Color(q, 255 - q, 0);
+	return tableColor(DAY_COLORS[n - 1]);
+}
+
+// Color of an animation palette index.
+uint32_t animationColor(uint8_t index) {
+	return tableColor(ANIMATION_PALETTE[index]);
+}
+
+// Read a color from a table in program memory.
+uint32_t tableColor(const uint8_t *entry) {
+	return rgbColor(pgm_read_byte(entry), pgm_read_byte(entry + 1), pgm_read_byte(entry + 2));
 }
 
 void configureFromMemory() {
-	PersistentParameters params;
+	PersistentParameters &params = warm_saved;
+	uint8_t version;
+
+	// Newest journal record, or the parameters saved before there was a journal.
+	if (journal.scan()) {
+		uint8_t length = journal.read(&version, &params, sizeof(params));
+		if (length < PARAMETERS_V2_LENGTH  ||  length < parametersLength(params.version))
+			params.version = 0;
+	}
+	else {
+		loadParameters(0, &params);
+	}
 
-	loadParameters(0, &params);
+	// Only version 3 on has a time.
+	if (params.version < 3)
+		params.timeFlags = 0;
+
+	// Settings made over the serial link, from version 4 on. They include whether to
+	// use the saved tick interval.
+	if (params.version >= 4  &&  params.version <= parametersVersion)
+		loadSettings(&params);
+
+	if (overrideSavedParameters)
+		return;
 
 	// Load up with defaults in case loaded params look weird.
 	tick_interval_cycles = 33333;
 	tick_frac_numerator = 21;  // 21/64
 
 	// Validate.
-	if (params.version < 1 || params.version > 2) {
-		Serial.print("configureFromMemory: bad version.  Expected 1 or 2; found ");
+	if (params.version < 1 || params.version > parametersVersion) {
+		Serial.print(F("configureFromMemory: bad version.  Expected 1 to 5; found "));
 		Serial.print(params.version);
+		params.timeFlags = 0;
 		return;
 	}
 
 	// Bound within 5% of standard
 	// if (params.scaledCounts < 506666  ||  params.scaledCounts > 560000) {
-	// 	Serial.print("configureFromMemory: scaledCount out of range. Found ");
+	// 	Serial.print(F("configureFromMemory: scaledCount out of range. Found "));
 	// 	Serial.print(params.scaledCounts);
 	// 	return;
 	// }
@@ -1576,6 +2652,9 @@ void configureFromMemory() {
 		break;
 
 		case 2:
+		case 3:
+		case 4:
+		case 5:
 		tick_frac_numerator = params.scaledCounts % 64;
 		tick_interval_cycles = params.scaledCounts / 64;
 		break;
@@ -1584,19 +2663,76 @@ void configureFromMemory() {
 
 }
 
-// Writes a parameters structure to EEPROM.  Returns number of bytes written.
-uint16_t saveParameters(uint16_t address, PersistentParameters *params) {
-	// Cast to byte pointer
-	byte *p = (byte *)(void *)params;
+// Bytes of PersistentParameters used by each version.
+uint8_t parametersLength(uint8_t version) {
+	if (version < 3)
+		return PARAMETERS_V2_LENGTH;
+	if (version == 3)
+		return PARAMETERS_V3_LENGTH;
+	if (version == 4)
+		return PARAMETERS_V4_LENGTH;
+	return sizeof(PersistentParameters);
+}
 
-	uint16_t i;
-	 for (i = 0; i < sizeof(PersistentParameters); i++) {
-        EEPROM.write(address++, *p++);
-	 }
-    return i;
+// Take the serial link settings from saved parameters. Any out of range keep their
+// current values.
+void loadSettings(const PersistentParameters *params) {
+	setSetting(SETTING_TZ_HOURS, params->tzOffsetHours);
+	setSetting(SETTING_TZ_MINUTES, params->tzOffsetMinutes);
+	setSetting(SETTING_OBSERVE_DST, (params->settingFlags & SAVED_SETTING_OBSERVE_DST) != 0);
+	setSetting(SETTING_OVERRIDE, (params->settingFlags & SAVED_SETTING_OVERRIDE) != 0);
+	setSetting(SETTING_SCORE_THRESHOLD, params->scoreThreshold);
+	setSetting(SETTING_DETECTED_THRESHOLD, params->detectedSymbolThreshold);
+	setSetting(SETTING_MISSED_THRESHOLD, params->missedSymbolThreshold);
+	if (params->version >= 5)
+		setSetting(SETTING_SECONDS_DUTY, params->secondsDuty);
 }
 
-// Reads a parameters sructure from EEPROM.  Returns number of bytes read.
+void storeSettings(PersistentParameters *params) {
+	params->tzOffsetHours = tzOffsetHours;
+	params->tzOffsetMinutes = tzOffsetMinutes;
+	params->settingFlags = 0;
+	if (observeDst) params->settingFlags |= SAVED_SETTING_OBSERVE_DST;
+	if (overrideSavedParameters) params->settingFlags |= SAVED_SETTING_OVERRIDE;
+	params->scoreThreshold = decoder.scoreThreshold;
+	params->detectedSymbolThreshold = decoder.detectedSymbolThreshold;
+	params->missedSymbolThreshold = decoder.missedSymbolThreshold;
+	params->secondsDuty = nixieSecondsDuty;
+}
+
+// Show the time saved before the restart, if there is one, as an estimate of the time
+// now. There is no clock running while the power is off, so the estimate is as old as
+// the outage, and colored by how fresh it was when saved. Returns true if there is one.
+bool warmStart() {
+	if (!(warm_saved.timeFlags & SAVED_TIME_VALID)  ||  warm_saved.hours > 23
+			||  warm_saved.minutes > 59  ||  warm_saved.seconds > 59
+			||  warm_saved.day < 1  ||  warm_saved.day > 366)
+		return false;
+
+	uint8_t oldSREG = SREG;
+	cli();
+	tod_ticks = 0;
+	tod_seconds = warm_saved.seconds;
+	tod_minutes = warm_saved.minutes;
+	tod_hours = warm_saved.hours;
+	tod_day = warm_saved.day;
+	tod_year = 2000 + warm_saved.year;
+	tod_isleapyear = warm_saved.timeFlags & SAVED_TIME_LEAP_YEAR;
+	tod_isdst = warm_saved.timeFlags & SAVED_TIME_DST;
+	tod_estimated = true;
+	SREG = oldSREG;
+
+	if (warm_saved.timeFlags & SAVED_TIME_POWER_LOSS)
+		tod_color = COLOR_TOD_ESTIMATED;
+	else
+		tod_color = COLOR_TOD_STALE;
+	tod_secondChanged = true;
+
+	return true;
+}
+
+// Reads a parameters sructure from EEPROM, as saved before the journal.  Returns number
+// of bytes read.
 uint16_t loadParameters(uint16_t address, PersistentParameters *params) {
 	// Cast to byte pointer
 	byte *p = (byte *)(void *)params;
@@ -1613,6 +2749,7 @@ void configureTickTimer() {
 
 	// Configure timer 1 to interrupt at 60Hz
 	OCR1A = tick_interval_cycles;
+	timer1_periodTop = tick_interval_cycles;
 
 	TCCR1A = 0;
 	// Mode 4, CTC on OCR1A, prescaler 8
@@ -1622,19 +2759,139 @@ void configureTickTimer() {
 	TIMSK1 |= (1 << OCIE1A);
 }
 
+// Select the bandgap as ADC input, against AVcc, and start the first conversion. The
+// ADC clock is 16MHz / 128; a conversion takes 13 ADC clocks, about 104us.
+void configureVccMonitor() {
+	ADMUX = _BV(REFS0) | _BV(MUX3) | _BV(MUX2) | _BV(MUX1);
+	ADCSRA = _BV(ADEN) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+	ADCSRA |= _BV(ADSC);
+}
+
+// Read the conversion started on the last tick, and start the next one. Called by tick().
+void measureVcc() {
+	if (ADCSRA & _BV(ADSC))
+		return;
+
+	uint16_t reading = ADC;
+	ADCSRA |= _BV(ADSC);
+	vcc_reading = reading;
+
+	if (!vcc_low  &&  reading > VCC_LOW_READING) {
+		vcc_low = true;
+		vcc_low_flag = true;
+	}
+	else if (vcc_low  &&  reading < VCC_RECOVERED_READING)
+		vcc_low = false;
+}
+
+// Supply voltage in millivolts, from the latest measurement.
+uint16_t vccMillivolts() {
+	uint16_t reading = vcc_reading;
+	return reading ? 1126400UL / reading : 0;
+}
+
+// Runs before the C runtime initializes memory. Keeps the reset cause, and turns off
+// the watchdog, which stays on after a watchdog reset. Optiboot clears MCUSR itself,
+// leaving its value in r2.
+void saveResetCause() __attribute__((naked, used, section(".init3")));
+void saveResetCause() {
+	reset_cause = MCUSR;
+	if (reset_cause == 0)
+		__asm__ __volatile__ ("sts %0, r2" : "=m" (reset_cause));
+	MCUSR = 0;
+	wdt_disable();
+}
+
+uint16_t recoveryCrc() {
+	const uint8_t *p = (const uint8_t *)&recovery;
+	uint16_t crc = 0xffff;
+	for (uint8_t i = 0;  i < sizeof(RecoveryState) - 2;  i++)
+		crc = _crc16_update(crc, p[i]);
+	return crc;
+}
+
+// Snapshot the time and tick interval for recoverState(). Called by tick().
+void saveRecoveryState() {
+	if (!recovery_armed)
+		return;
+
+	recovery.tickIntervalCycles = tick_interval_cycles;
+	recovery.tickFracNumerator = tick_frac_numerator;
+	recovery.mode = decoder.getMode();
+	recovery.ticks = tod_ticks;
+	recovery.seconds = tod_seconds;
+	recovery.minutes = tod_minutes;
+	recovery.hours = tod_hours;
+	recovery.day = tod_day;
+	recovery.year = tod_year;
+	recovery.flags = 0;
+	if (tod_fix) recovery.flags |= RECOVERY_FIX;
+	if (tod_estimated) recovery.flags |= RECOVERY_ESTIMATED;
+	if (tod_isleapyear) recovery.flags |= RECOVERY_LEAP_YEAR;
+	if (tod_isdst) recovery.flags |= RECOVERY_DST;
+	recovery.crc = recoveryCrc();
+}
+
+// Take the time from the snapshot if the reset kept SRAM (watchdog or external reset) and
+// the snapshot is intact. The tick interval is left in the snapshot for setup(). Returns
+// true if recovered.
+//
+// The time is late by the reset, and by setup() up to the start of the tick timer. After
+// a watchdog reset that is the start-up delay and the bootloader's quick exit, tens of
+// milliseconds, which the next frame corrects. After an external reset, such as DTR from
+// a serial port being opened, the bootloader first waits about a second for an upload.
+// That is too long to keep the time as a fix, and too uncertain to correct for, so it is
+// kept only as an estimate, for the early frame check to confirm.
+bool recoverState() {
+	if (!(reset_cause & (_BV(WDRF) | _BV(EXTRF)))  ||  (reset_cause & _BV(PORF)))
+		return false;
+	if (recovery.crc != recoveryCrc())
+		return false;
+
+	tod_ticks = recovery.ticks;
+	tod_seconds = recovery.seconds;
+	tod_minutes = recovery.minutes;
+	tod_hours = recovery.hours;
+	tod_day = recovery.day;
+	tod_year = recovery.year;
+	bool external = reset_cause & _BV(EXTRF);
+	tod_fix = (recovery.flags & RECOVERY_FIX)  &&  !external;
+	tod_estimated = (recovery.flags & (RECOVERY_FIX | RECOVERY_ESTIMATED))  &&  !tod_fix;
+	tod_isleapyear = recovery.flags & RECOVERY_LEAP_YEAR;
+	tod_isdst = recovery.flags & RECOVERY_DST;
+
+	if (tod_fix)
+		tod_color = COLOR_TOD_FIX;
+	else if (tod_estimated)
+		tod_color = COLOR_TOD_STALE;
+	tod_secondChanged = true;
+
+	return true;
+}
+
 void configurePwmTimer() {
-	// Configure timer 2 for PWM at 244Hz
-	// Arduino pin 3 is OC2B
+	// Configure timer 2 for fast PWM at 2kHz: mode 7, TOP = OCR2A, prescaler 64.
+	// Arduino pin 3 is OC2B, inverted, so the tubes are enabled from BOTTOM to OCR2B.
 	TCCR2A = _BV(COM2B1) | _BV(COM2B0) | _BV(WGM21) | _BV(WGM20);
- 	TCCR2B = _BV(CS22) | _BV(CS21);
-	OCR2B = 255;
+	TCCR2B = _BV(WGM22) | _BV(CS22);
+	OCR2A = TUBE_PWM_TOP;
+	OCR2B = TUBE_PWM_MAX;
+
+	// Interrupt when the tubes go dark, to latch the next slot while they are off. See
+	// TUBE_PWM_DARK_COUNTS.
+	TIMSK2 |= _BV(OCIE2B);
 }
 
 // 60Hz tick interrupt.
 ISR (TIMER1_COMPA_vect) {
+	// Counts since the compare match
+	uint16_t entry = TCNT1;
 
 	// Set heartbeat pin high
-	PORTD |= B00000100;
+	HeartbeatPin::high();
+
+	// The period that just ended is now part of the running count.
+	timer1_periodStart += (uint32_t)timer1_periodTop + 1;
 
 	// Current fractional period index. Counts from 0 to tick_frac_denominator-1.
 	// When heartbeat_period < tick_frac_numerator, set counter for a long
@@ -1655,11 +2912,83 @@ ISR (TIMER1_COMPA_vect) {
 		// Short period: n-1
 		OCR1A = tick_interval_cycles-1;
 	}
+	timer1_periodTop = OCR1A;
 
 	tick();
 
-	// Set heartbeat pin low
-	PORTD &= B11111011;
+	if (loop_progress) {
+		wdt_reset();
+		loop_progress = false;
+	}
+
+	profiler.record(PROFILE_TICK_LATENCY, entry);
+	profiler.record(PROFILE_TICK, Profiler::elapsed(entry, TCNT1, timer1_periodTop));
+
+	// Set heartbeat pin low, unless it's showing a task running
+	HeartbeatPin::write(loop_busy);
+}
+
+// Returns the number of Timer1 counts (0.5us each) since startup. Wraps after
+// about 35 minutes. Safe to call with interrupts enabled or disabled.
+uint32_t timer1Counts() {
+	uint8_t oldSREG = SREG;
+	cli();
+
+	uint32_t start = timer1_periodStart;
+	uint16_t top = timer1_periodTop;
+	uint16_t count = TCNT1;
+
+	// A compare match that the ISR hasn't serviced yet means the counter has
+	// already wrapped back to zero.
+	if ((TIFR1 & _BV(OCF1A))  &&  count < (top >> 1))
+		start += (uint32_t)top + 1;
+
+	SREG = oldSREG;
+	return start + count;
+}
+
+// Returns the number of CPU cycles since startup, to a resolution of 8 cycles
+// (the Timer1 prescaler). Wraps after about 4.5 minutes.
+uint32_t cycleCount() {
+	return timer1Counts() << 3;
+}
+
+// Pin change interrupt for PORT D: the receiver output changed. Timestamp the edge
+// to the resolution of Timer1 (0.5us). The timestamp is late by the interrupt latency,
+// which is longest when the edge arrives during the tick ISR.
+ISR(PCINT2_vect) {
+	edgeReceiver.pushEdge(timer1Counts(), WwvbPin::read());
+	edge_flag = true;
+}
+
+// Tubes switched off for the rest of the PWM cycle: send the frame for the next slot,
+// if it differs from the one showing.
+ISR(TIMER2_COMPB_vect) {
+	const uint8_t *frame = nixieEngine.nextSlot();
+	if (frame)
+		transmitNixieFrame(frame);
+}
+
+// EEPROM ready for another byte.
+ISR(EE_READY_vect) {
+	eepromWriter.service();
+}
+
+// SPI transfer complete: send the next byte of the nixie frame, or latch the frame
+// into the tube drivers after the last one.
+ISR(SPI_STC_vect) {
+	if (nixieTxIndex < 6) {
+		SPDR = nixieTxFrame[nixieTxIndex++];
+		return;
+	}
+
+	RckPin::high();
+	nixieTxBusy = false;
+
+	if (nixieTxPending) {
+		nixieTxPending = false;
+		startNixieTransfer(nixieTxPendingFrame);
+	}
 }
 
 // Pin change interrupt for PORT C: Button was pressed/released, or
@@ -1738,70 +3067,103 @@ ISR(PCINT1_vect)
 // Diagnostic to echo sample data on the terminal. Bytes are space-separated; but
 // leading zeroes are omitted; remember to mentally fill in enough zeroes on each segment to make 8 bits.
 void printSamples() {
-	Serial.print(samples[9], BIN);
+	Serial.print(decoder.getSample(9), BIN);
 	Serial.print(' ');
-	Serial.print(samples[8], BIN);
+	Serial.print(decoder.getSample(8), BIN);
 	Serial.print(' ');
-	Serial.print(samples[7], BIN);
+	Serial.print(decoder.getSample(7), BIN);
 	Serial.print(' ');
-	Serial.print(samples[6], BIN);
+	Serial.print(decoder.getSample(6), BIN);
 	Serial.print(' ');
-	Serial.print(samples[5], BIN);
+	Serial.print(decoder.getSample(5), BIN);
 	Serial.print(' ');
-	Serial.print(samples[4], BIN);
+	Serial.print(decoder.getSample(4), BIN);
 	Serial.print(' ');
-	Serial.print(samples[3], BIN);
+	Serial.print(decoder.getSample(3), BIN);
 	Serial.print(' ');
-	Serial.print(samples[2], BIN);
+	Serial.print(decoder.getSample(2), BIN);
 	Serial.print(' ');
-	Serial.print(samples[1], BIN);
+	Serial.print(decoder.getSample(1), BIN);
 	Serial.print(' ');
-	Serial.print(samples[0], BIN);
+	Serial.print(decoder.getSample(0), BIN);
 	Serial.print('\n');
 }
 
 // Diagnositc to echo the decoded symbols in the symbol buffer.
 void printSymbols() {
 	for (int i = 0;  i<60;  i++) {
-		Serial.print(symbolStream[i]);
+		Serial.print(decoder.getStream()[i]);
+	}
+	Serial.print('\n');
+}
+
+// Diagnostic to print the scheduler's per-task runtime accounting. Times are in
+// CPU cycles.
+void printTaskStats() {
+	Serial.print(F("task      runs      mean       max   latency  misses\n"));
+	for (uint8_t i = 0;  i<scheduler.getCount();  i++) {
+		Task *task = scheduler.getTask(i);
+		Serial.print((const __FlashStringHelper *)task->name);
+		Serial.print('\t');
+		Serial.print(task->runCount);
+		Serial.print('\t');
+		if (task->runCount > 0)
+			Serial.print(task->totalCycles / task->runCount);
+		else
+			Serial.print('-');
+		Serial.print('\t');
+		Serial.print(task->maxCycles);
+		Serial.print('\t');
+		Serial.print(task->maxLatencyCycles);
+		Serial.print('\t');
+		Serial.print(task->deadlineMisses);
+		Serial.print('\n');
 	}
+}
+
+// Diagnostic to print the time shown on the tubes, decoded from nixieData.
+void printNixies() {
+	char text[9];
+	renderNixies(nixieData, text);
+	Serial.print(F("Nixies: "));
+	Serial.print(text);
 	Serial.print('\n');
 }
 
 // Print the scores over the serial port.
 void printScores(uint8_t zero, uint8_t one, uint8_t marker) {
 	static bool separated = false;
-	if (zero > scoreThreshold || one > scoreThreshold || marker > scoreThreshold) {
+	if (zero > decoder.scoreThreshold || one > decoder.scoreThreshold || marker > decoder.scoreThreshold) {
 		Serial.print(zero);
-		if (zero > scoreThreshold)
-			Serial.print("**  ");
+		if (zero > decoder.scoreThreshold)
+			Serial.print(F("**  "));
 		else
-			Serial.print("    ");
+			Serial.print(F("    "));
 	
 		Serial.print(one);
-		if (one > scoreThreshold)
-			Serial.print("**  ");
+		if (one > decoder.scoreThreshold)
+			Serial.print(F("**  "));
 		else
-			Serial.print("    ");
+			Serial.print(F("    "));
 
 		Serial.print(marker);
-		if (marker > scoreThreshold)
-			Serial.print("**\n");
+		if (marker > decoder.scoreThreshold)
+			Serial.print(F("**\n"));
 		else
-			Serial.print("\n");
+			Serial.print(F("\n"));
 
 		separated = false;
 	}
 	else {
 		if (!separated) {
-			Serial.print("----------\n");
+			Serial.print(F("----------\n"));
 			separated = true;
 		}
 	}
 }
 
 void printTimeUtc() {
-		Serial.print("Time of day (UTC): ");
+		Serial.print(F("Time of day (UTC): "));
 		Serial.print(tod_hours);
 		Serial.print(':');
 		if (tod_minutes < 10)
@@ -1815,138 +3177,141 @@ void printTimeUtc() {
 }
 
 void test_showPatterns() {
-	Serial.print("PATTERN_ZERO: ");
-	Serial.print(PATTERN_ZERO[9], BIN);
+	Serial.print(F("PATTERN_ZERO: "));
+	Serial.print(pgm_read_byte(&WwvbDecoder::patternZero[9]), BIN);
 	Serial.print(' ');
-	Serial.print(PATTERN_ZERO[8], BIN);
+	Serial.print(pgm_read_byte(&WwvbDecoder::patternZero[8]), BIN);
 	Serial.print(' ');
-	Serial.print(PATTERN_ZERO[7], BIN);
+	Serial.print(pgm_read_byte(&WwvbDecoder::patternZero[7]), BIN);
 	Serial.print(' ');
-	Serial.print(PATTERN_ZERO[6], BIN);
+	Serial.print(pgm_read_byte(&WwvbDecoder::patternZero[6]), BIN);
 	Serial.print(' ');
-	Serial.print(PATTERN_ZERO[5], BIN);
+	Serial.print(pgm_read_byte(&WwvbDecoder::patternZero[5]), BIN);
 	Serial.print(' ');
-	Serial.print(PATTERN_ZERO[4], BIN);
+	Serial.print(pgm_read_byte(&WwvbDecoder::patternZero[4]), BIN);
 	Serial.print(' ');
-	Serial.print(PATTERN_ZERO[3], BIN);
+	Serial.print(pgm_read_byte(&WwvbDecoder::patternZero[3]), BIN);
 	Serial.print(' ');
-	Serial.print(PATTERN_ZERO[2], BIN);
+	Serial.print(pgm_read_byte(&WwvbDecoder::patternZero[2]), BIN);
 	Serial.print(' ');
-	Serial.print(PATTERN_ZERO[1], BIN);
+	Serial.print(pgm_read_byte(&WwvbDecoder::patternZero[1]), BIN);
 	Serial.print(' ');
-	Serial.print(PATTERN_ZERO[0], BIN);
+	Serial.print(pgm_read_byte(&WwvbDecoder::patternZero[0]), BIN);
 	Serial.print('\n');
 
-	Serial.print("PATTERN_ONE: ");
-	Serial.print(PATTERN_ONE[9], BIN);
+	Serial.print(F("PATTERN_ONE: "));
+	Serial.print(pgm_read_byte(&WwvbDecoder::patternOne[9]), BIN);
 	Serial.print(' ');
-	Serial.print(PATTERN_ONE[8], BIN);
+	Serial.print(pgm_read_byte(&WwvbDecoder::patternOne[8]), BIN);
 	Serial.print(' ');
-	Serial.print(PATTERN_ONE[7], BIN);
+	Serial.print(pgm_read_byte(&WwvbDecoder::patternOne[7]), BIN);
 	Serial.print(' ');
-	Serial.print(PATTERN_ONE[6], BIN);
+	Serial.print(pgm_read_byte(&WwvbDecoder::patternOne[6]), BIN);
 	Serial.print(' ');
-	Serial.print(PATTERN_ONE[5], BIN);
+	Serial.print(pgm_read_byte(&WwvbDecoder::patternOne[5]), BIN);
 	Serial.print(' ');
-	Serial.print(PATTERN_ONE[4], BIN);
+	Serial.print(pgm_read_byte(&WwvbDecoder::patternOne[4]), BIN);
 	Serial.print(' ');
-	Serial.print(PATTERN_ONE[3], BIN);
+	Serial.print(pgm_read_byte(&WwvbDecoder::patternOne[3]), BIN);
 	Serial.print(' ');
-	Serial.print(PATTERN_ONE[2], BIN);
+	Serial.print(pgm_read_byte(&WwvbDecoder::patternOne[2]), BIN);
 	Serial.print(' ');
-	Serial.print(PATTERN_ONE[1], BIN);
+	Serial.print(pgm_read_byte(&WwvbDecoder::patternOne[1]), BIN);
 	Serial.print(' ');
-	Serial.print(PATTERN_ONE[0], BIN);
+	Serial.print(pgm_read_byte(&WwvbDecoder::patternOne[0]), BIN);
 	Serial.print('\n');
 
-	Serial.print("PATTERN_MARKER: ");
-	Serial.print(PATTERN_MARKER[9], BIN);
+	Serial.print(F("PATTERN_MARKER: "));
+	Serial.print(pgm_read_byte(&WwvbDecoder::patternMarker[9]), BIN);
 	Serial.print(' ');
-	Serial.print(PATTERN_MARKER[8], BIN);
+	Serial.print(pgm_read_byte(&WwvbDecoder::patternMarker[8]), BIN);
 	Serial.print(' ');
-	Serial.print(PATTERN_MARKER[7], BIN);
+	Serial.print(pgm_read_byte(&WwvbDecoder::patternMarker[7]), BIN);
 	Serial.print(' ');
-	Serial.print(PATTERN_MARKER[6], BIN);
+	Serial.print(pgm_read_byte(&WwvbDecoder::patternMarker[6]), BIN);
 	Serial.print(' ');
-	Serial.print(PATTERN_MARKER[5], BIN);
+	Serial.print(pgm_read_byte(&WwvbDecoder::patternMarker[5]), BIN);
 	Serial.print(' ');
-	Serial.print(PATTERN_MARKER[4], BIN);
+	Serial.print(pgm_read_byte(&WwvbDecoder::patternMarker[4]), BIN);
 	Serial.print(' ');
-	Serial.print(PATTERN_MARKER[3], BIN);
+	Serial.print(pgm_read_byte(&WwvbDecoder::patternMarker[3]), BIN);
 	Serial.print(' ');
-	Serial.print(PATTERN_MARKER[2], BIN);
+	Serial.print(pgm_read_byte(&WwvbDecoder::patternMarker[2]), BIN);
 	Serial.print(' ');
-	Serial.print(PATTERN_MARKER[1], BIN);
+	Serial.print(pgm_read_byte(&WwvbDecoder::patternMarker[1]), BIN);
 	Serial.print(' ');
-	Serial.print(PATTERN_MARKER[0], BIN);
+	Serial.print(pgm_read_byte(&WwvbDecoder::patternMarker[0]), BIN);
 	Serial.print('\n');
 }
 
 void test_shifter() {
+	// A decoder of its own, to leave the receiver's samples alone
+	WwvbDecoder tester;
+
 	// Shift in a simulated PATTERN_ZERO, then compare to the other patterns
 	for (short i=0; i<10; i++) {
-		shiftSample(0);
+		tester.shiftSample(0);
 	}
 	for (short i=0; i<12; i++) {
-		shiftSample(1);
+		tester.shiftSample(1);
 	}
 	for (short i=0; i<48; i++) {
-		shiftSample(0);
+		tester.shiftSample(0);
 	}
 
 	for (short i=0; i<10; i++) {
-		shiftSample(1);
+		tester.shiftSample(1);
 	}
 
-	Serial.print("ZERO on ZERO: ");
-	Serial.print(score(PATTERN_ZERO));
-	Serial.print("\nZERO on ONE: ");
-	Serial.print(score(PATTERN_ONE));
-	Serial.print("\nZERO on MARKER: ");
-	Serial.print(score(PATTERN_MARKER));
-	Serial.print("\n");
+	Serial.print(F("ZERO on ZERO: "));
+	Serial.print(tester.score(WwvbDecoder::patternZero));
+	Serial.print(F("\nZERO on ONE: "));
+	Serial.print(tester.score(WwvbDecoder::patternOne));
+	Serial.print(F("\nZERO on MARKER: "));
+	Serial.print(tester.score(WwvbDecoder::patternMarker));
+	Serial.print(F("\n"));
 
 	// Shift in a simulated PATTERN_ONE, then compare to the other patterns
 	for (short i=0; i<10; i++) {
-		shiftSample(0);
+		tester.shiftSample(0);
 	}
 	for (short i=0; i<30; i++) {
-		shiftSample(1);
+		tester.shiftSample(1);
 	}
 	for (short i=0; i<30; i++) {
-		shiftSample(0);
+		tester.shiftSample(0);
 	}
 	for (short i=0; i<10; i++) {
-		shiftSample(1);
+		tester.shiftSample(1);
 	}
 
-	Serial.print("ONE on ZERO: ");
-	Serial.print(score(PATTERN_ZERO));
-	Serial.print("\nONE on ONE: ");
-	Serial.print(score(PATTERN_ONE));
-	Serial.print("\nONE on MARKER: ");
-	Serial.print(score(PATTERN_MARKER));
-	Serial.print("\n");
+	Serial.print(F("ONE on ZERO: "));
+	Serial.print(tester.score(WwvbDecoder::patternZero));
+	Serial.print(F("\nONE on ONE: "));
+	Serial.print(tester.score(WwvbDecoder::patternOne));
+	Serial.print(F("\nONE on MARKER: "));
+	Serial.print(tester.score(WwvbDecoder::patternMarker));
+	Serial.print(F("\n"));
 
 	// Shift in a simulated PATTERN_MARKER, then compare to the other patterns
 	for (short i=0; i<10; i++) {
-		shiftSample(0);
+		tester.shiftSample(0);
 	}
 	for (short i=0; i<48; i++) {
-		shiftSample(1);
+		tester.shiftSample(1);
 	}
 	for (short i=0; i<12; i++) {
-		shiftSample(0);
+		tester.shiftSample(0);
 	}
 	for (short i=0; i<10; i++) {
-		shiftSample(1);
+		tester.shiftSample(1);
 	}
 	
-	Serial.print("MARKER on ZERO: ");
-	Serial.print(score(PATTERN_ZERO));
-	Serial.print("\nMARKER on ONE: ");
-	Serial.print(score(PATTERN_ONE));
-	Serial.print("\nMARKER on MARKER: ");
-	Serial.print(score(PATTERN_MARKER));
-	Serial.print("\n");
+	Serial.print(F("MARKER on ZERO: "));
+	Serial.print(tester.score(WwvbDecoder::patternZero));
+	Serial.print(F("\nMARKER on ONE: "));
+	Serial.print(tester.score(WwvbDecoder::patternOne));
+	Serial.print(F("\nMARKER on MARKER: "));
+	Serial.print(tester.score(WwvbDecoder::patternMarker));
+	Serial.print(F("\n"));
 }
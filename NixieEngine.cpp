@@ -0,0 +1,177 @@
+#include "NixieEngine.h"
+
+NixieEngine::NixieEngine() {
+	for (uint8_t i=0;  i<6;  i++) {
+		current[i] = 0;
+		previous[i] = 0;
+	}
+
+	for (uint8_t tube=0;  tube<NIXIE_TUBES;  tube++)
+		duty[tube] = slots;
+
+	fadeStep = fadeSteps;
+	fadePeriods = 8;
+	fadeCountdown = 0;
+	slot = 0;
+	dirty = true;
+	front = 0;
+	ready = false;
+	changed[0] = 0;
+	changed[1] = 0;
+}
+
+// Show a new frame. With crossfade, each tube that changes fades from its old digit to
+// its new one over the next fadeSteps * fadePeriods PWM periods. A frame set in the middle
+// of a fade replaces the faded-in frame, and fades from the one it was replacing; a digit
+// that has gone through most of its fade is close enough to finished.
+void NixieEngine::setFrame(const volatile uint8_t *frame, bool crossfade) {
+	uint8_t oldSREG = SREG;
+	cli();
+
+	// Setting the same frame again must not restart its fade.
+	bool same = true;
+	for (uint8_t i=0;  i<6;  i++) {
+		if (frame[i] != current[i]) {
+			same = false;
+			break;
+		}
+	}
+
+	if (same) {
+		SREG = oldSREG;
+		return;
+	}
+
+	for (uint8_t i=0;  i<6;  i++) {
+		if (fadeStep >= fadeSteps/2)
+			previous[i] = current[i];
+		current[i] = frame[i];
+	}
+
+	fadeStep = crossfade ? 0 : fadeSteps;
+	fadeCountdown = fadePeriods;
+	dirty = true;
+
+	SREG = oldSREG;
+}
+
+void NixieEngine::setDuty(uint8_t tube, uint8_t value) {
+	if (value > slots)
+		value = slots;
+
+	duty[tube] = value;
+	dirty = true;
+}
+
+uint8_t NixieEngine::getDuty(uint8_t tube) {
+	return duty[tube];
+}
+
+// PWM periods per fade step.
+void NixieEngine::setFadePeriods(uint8_t periods) {
+	fadePeriods = periods;
+}
+
+// Set when the schedule needs rebuilding: the release flag for the task that calls build().
+volatile bool *NixieEngine::getBuildFlag() {
+	return &dirty;
+}
+
+// Advance to the next slot. Returns the frame to send for it, or NULL when the tubes
+// should keep the frame they have. Call from the PWM timer interrupt, once per slot.
+const uint8_t *NixieEngine::nextSlot() {
+	if (++slot >= slots) {
+		slot = 0;
+
+		if (fadeStep < fadeSteps  &&  --fadeCountdown == 0) {
+			fadeStep++;
+			fadeCountdown = fadePeriods;
+			dirty = true;
+		}
+
+		// Take up a newly built schedule. The tubes may still be showing a frame from
+		// the old one, so always send its first slot.
+		if (ready) {
+			front ^= 1;
+			ready = false;
+			return schedule[front][0];
+		}
+	}
+
+	if (changed[front] & (1 << slot))
+		return schedule[front][slot];
+
+	return NULL;
+}
+
+// Work out the frame for every slot into the back schedule, for nextSlot() to swap in at
+// the start of the next period. Tube t is lit for the first duty[t] slots of the period;
+// during a fade, the new digit gets the first part of them and the old digit the rest.
+// Call from the main loop, not an interrupt: it takes a few hundred microseconds.
+void NixieEngine::build() {
+	uint8_t newFrame[6];
+	uint8_t oldFrame[6];
+	uint8_t lit[NIXIE_TUBES];
+	uint8_t step;
+
+	// Take a consistent copy of the inputs, which the interrupts may change. Withdraw any
+	// schedule not yet swapped in, so the back one is ours until ready is set again.
+	uint8_t oldSREG = SREG;
+	cli();
+	dirty = false;
+	ready = false;
+	for (uint8_t i=0;  i<6;  i++) {
+		newFrame[i] = current[i];
+		oldFrame[i] = previous[i];
+	}
+	for (uint8_t tube=0;  tube<NIXIE_TUBES;  tube++)
+		lit[tube] = duty[tube];
+	step = fadeStep;
+	SREG = oldSREG;
+
+	uint8_t back = front ^ 1;
+	uint8_t (*next)[6] = schedule[back];
+
+	for (uint8_t s=0;  s<slots;  s++)
+		for (uint8_t i=0;  i<6;  i++)
+			next[s][i] = 0;
+
+	for (uint8_t tube=0;  tube<NIXIE_TUBES;  tube++) {
+		uint8_t fresh = ((uint16_t)lit[tube] * step + fadeSteps/2) / fadeSteps;
+
+		// A tube spans no more than two bytes of the frame.
+		for (uint8_t i=0;  i<6;  i++) {
+			uint8_t mask = pgm_read_byte(&NIXIE_TUBE_MASKS[tube][i]);
+			if (mask == 0)
+				continue;
+
+			uint8_t newBits = newFrame[i] & mask;
+			uint8_t oldBits = oldFrame[i] & mask;
+
+			for (uint8_t s=0;  s<lit[tube];  s++)
+				next[s][i] |= (s < fresh) ? newBits : oldBits;
+		}
+	}
+
+	// A slot needs sending when it differs from the one before it, which for slot 0 is
+	// the last slot of the previous period.
+	uint8_t sends = 0;
+	for (uint8_t s=1;  s<slots;  s++) {
+		for (uint8_t i=0;  i<6;  i++) {
+			if (next[s][i] != next[s-1][i]) {
+				sends |= 1 << s;
+				break;
+			}
+		}
+	}
+
+	for (uint8_t i=0;  i<6;  i++) {
+		if (next[0][i] != next[slots-1][i]) {
+			sends |= 0x01;
+			break;
+		}
+	}
+
+	changed[back] = sends;
+	ready = true;
+}
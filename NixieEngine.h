@@ -0,0 +1,66 @@
+#ifndef NixieEngine_h
+#define NixieEngine_h
+
+#include <Arduino.h>
+#include "NixieSegments.h"
+
+// Multiplexed output for the nixie tubes. Each PWM period of the tube enable is split
+// into a number of slots, and a different frame can be latched into the tube drivers at
+// the start of each slot. That gives every tube its own duty cycle, and lets the old
+// digit of a tube crossfade into the new one by handing slots over a few at a time.
+//
+// The frames for all slots are worked out ahead of time into a schedule, which is only
+// rebuilt when the frame, a duty cycle, or the fade step changes. The schedule marks the
+// slots whose frame differs from the slot before, so a steady display needs no transfers
+// at all.
+//
+// The schedule is double buffered. build() runs from the main loop, whenever the flag
+// from getBuildFlag() is set, and fills the back schedule; nextSlot() runs in the PWM
+// timer interrupt, and only swaps to it at the start of a period.
+class NixieEngine {
+
+	public:
+		// Slots per PWM period; also the full duty cycle of a tube.
+		static const uint8_t slots = 8;
+
+		// Fade steps from the old frame to the new one.
+		static const uint8_t fadeSteps = slots;
+
+		NixieEngine();
+
+		void setFrame(const volatile uint8_t *frame, bool crossfade);
+		void setDuty(uint8_t tube, uint8_t duty);
+		uint8_t getDuty(uint8_t tube);
+		void setFadePeriods(uint8_t periods);
+
+		volatile bool *getBuildFlag();
+		void build();
+
+		const uint8_t *nextSlot();
+
+	private:
+		// Frame being faded in, and the frame it replaces
+		uint8_t current[6];
+		uint8_t previous[6];
+
+		// Lit slots per period, 0 (off) to slots (always on)
+		uint8_t duty[NIXIE_TUBES];
+
+		uint8_t fadeStep;
+		uint8_t fadePeriods;
+		uint8_t fadeCountdown;
+
+		uint8_t slot;
+		volatile bool dirty;
+
+		// Front schedule, read by nextSlot(), and the back one, written by build().
+		// ready is set when the back one is complete, and cleared by the swap.
+		uint8_t schedule[2][slots][6];
+		uint8_t front;
+		volatile bool ready;
+
+		// Bit n set when slot n must be sent, for each schedule
+		uint8_t changed[2];
+};
+
+#endif
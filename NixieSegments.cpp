@@ -0,0 +1,156 @@
+#include "NixieSegments.h"
+
+// Layout of the 6-byte frame shifted out to the tube drivers. Each bit drives one
+// cathode.
+//
+//	Byte	Bits	Cathodes
+//	0		0-2		hours units 7-9
+//			4-5		hours tens 1-2 (tens 0 is bit 3, never lit: leading zero suppressed)
+//	1		0		minutes tens 5
+//			1-7		hours units 0-6
+//	2		0-2		minutes units 7-9
+//			3-7		minutes tens 0-4
+//	3		0		seconds tens 6 (leap second)
+//			1-7		minutes units 0-6
+//	4		0-1		seconds units 8-9
+//			2-7		seconds tens 0-5
+//	5		0-7		seconds units 0-7
+
+// Bytes of the row for one value of each field, as constant expressions of tens and units.
+#define HOURS_0(t, u)		(((u) >= 7 ? 1 << ((u)-7) : 0) | ((t) > 0 ? 1 << ((t)+3) : 0))
+#define HOURS_1(t, u)		((u) < 7 ? 1 << ((u)+1) : 0)
+#define HOURS(v)			{ HOURS_0((v)/10, (v)%10), HOURS_1((v)/10, (v)%10), 0, 0, 0, 0 }
+
+#define MINUTES_1(t, u)		((t) >= 5 ? 1 : 0)
+#define MINUTES_2(t, u)		(((u) >= 7 ? 1 << ((u)-7) : 0) | ((t) < 5 ? 1 << ((t)+3) : 0))
+#define MINUTES_3(t, u)		((u) < 7 ? 1 << ((u)+1) : 0)
+#define MINUTES(v)			{ 0, MINUTES_1((v)/10, (v)%10), MINUTES_2((v)/10, (v)%10), MINUTES_3((v)/10, (v)%10), 0, 0 }
+
+#define SECONDS_3(t, u)		((t) >= 6 ? 1 : 0)
+#define SECONDS_4(t, u)		(((u) >= 8 ? 1 << ((u)-8) : 0) | ((t) < 6 ? 1 << ((t)+2) : 0))
+#define SECONDS_5(t, u)		((u) < 8 ? 1 << (u) : 0)
+#define SECONDS(v)			{ 0, 0, 0, SECONDS_3((v)/10, (v)%10), SECONDS_4((v)/10, (v)%10), SECONDS_5((v)/10, (v)%10) }
+
+const uint8_t NIXIE_HOURS_SEGMENTS[24][6] PROGMEM = {
+	HOURS(0),  HOURS(1),  HOURS(2),  HOURS(3),  HOURS(4),  HOURS(5),
+	HOURS(6),  HOURS(7),  HOURS(8),  HOURS(9),  HOURS(10),  HOURS(11),
+	HOURS(12),  HOURS(13),  HOURS(14),  HOURS(15),  HOURS(16),  HOURS(17),
+	HOURS(18),  HOURS(19),  HOURS(20),  HOURS(21),  HOURS(22),  HOURS(23),
+};
+
+const uint8_t NIXIE_MINUTES_SEGMENTS[60][6] PROGMEM = {
+	MINUTES(0),  MINUTES(1),  MINUTES(2),  MINUTES(3),  MINUTES(4),  MINUTES(5),  MINUTES(6),  MINUTES(7),  MINUTES(8),  MINUTES(9),
+	MINUTES(10),  MINUTES(11),  MINUTES(12),  MINUTES(13),  MINUTES(14),  MINUTES(15),  MINUTES(16),  MINUTES(17),  MINUTES(18),  MINUTES(19),
+	MINUTES(20),  MINUTES(21),  MINUTES(22),  MINUTES(23),  MINUTES(24),  MINUTES(25),  MINUTES(26),  MINUTES(27),  MINUTES(28),  MINUTES(29),
+	MINUTES(30),  MINUTES(31),  MINUTES(32),  MINUTES(33),  MINUTES(34),  MINUTES(35),  MINUTES(36),  MINUTES(37),  MINUTES(38),  MINUTES(39),
+	MINUTES(40),  MINUTES(41),  MINUTES(42),  MINUTES(43),  MINUTES(44),  MINUTES(45),  MINUTES(46),  MINUTES(47),  MINUTES(48),  MINUTES(49),
+	MINUTES(50),  MINUTES(51),  MINUTES(52),  MINUTES(53),  MINUTES(54),  MINUTES(55),  MINUTES(56),  MINUTES(57),  MINUTES(58),  MINUTES(59),
+};
+
+// 0 to 60, to allow for a leap second.
+const uint8_t NIXIE_SECONDS_SEGMENTS[61][6] PROGMEM = {
+	SECONDS(0),  SECONDS(1),  SECONDS(2),  SECONDS(3),  SECONDS(4),  SECONDS(5),  SECONDS(6),  SECONDS(7),  SECONDS(8),  SECONDS(9),
+	SECONDS(10),  SECONDS(11),  SECONDS(12),  SECONDS(13),  SECONDS(14),  SECONDS(15),  SECONDS(16),  SECONDS(17),  SECONDS(18),  SECONDS(19),
+	SECONDS(20),  SECONDS(21),  SECONDS(22),  SECONDS(23),  SECONDS(24),  SECONDS(25),  SECONDS(26),  SECONDS(27),  SECONDS(28),  SECONDS(29),
+	SECONDS(30),  SECONDS(31),  SECONDS(32),  SECONDS(33),  SECONDS(34),  SECONDS(35),  SECONDS(36),  SECONDS(37),  SECONDS(38),  SECONDS(39),
+	SECONDS(40),  SECONDS(41),  SECONDS(42),  SECONDS(43),  SECONDS(44),  SECONDS(45),  SECONDS(46),  SECONDS(47),  SECONDS(48),  SECONDS(49),
+	SECONDS(50),  SECONDS(51),  SECONDS(52),  SECONDS(53),  SECONDS(54),  SECONDS(55),  SECONDS(56),  SECONDS(57),  SECONDS(58),  SECONDS(59),
+	SECONDS(60),
+};
+
+const uint8_t NIXIE_FIELD_MASKS[3][6] PROGMEM = {
+	{ 0xff, 0xfe, 0x00, 0x00, 0x00, 0x00 },		// Hours
+	{ 0x00, 0x01, 0xff, 0xfe, 0x00, 0x00 },		// Minutes
+	{ 0x00, 0x00, 0x00, 0x01, 0xff, 0xff },		// Seconds
+};
+
+#define X NIXIE_NO_CATHODE
+const uint8_t NIXIE_TUBE_CATHODES[NIXIE_TUBES][10] PROGMEM = {
+	// 0	1	2	3	4	5	6	7	8	9
+	{  3,	4,	5,	6,	7,	X,	X,	X,	X,	X },	// Hours tens
+	{  9,	10,	11,	12,	13,	14,	15,	0,	1,	2 },	// Hours units
+	{  19,	20,	21,	22,	23,	8,	X,	X,	X,	X },	// Minutes tens
+	{  25,	26,	27,	28,	29,	30,	31,	16,	17,	18 },	// Minutes units
+	{  34,	35,	36,	37,	38,	39,	24,	X,	X,	X },	// Seconds tens
+	{  40,	41,	42,	43,	44,	45,	46,	47,	32,	33 },	// Seconds units
+};
+#undef X
+
+const uint8_t NIXIE_TUBE_MASKS[NIXIE_TUBES][6] PROGMEM = {
+	{ 0xf8, 0x00, 0x00, 0x00, 0x00, 0x00 },		// Hours tens
+	{ 0x07, 0xfe, 0x00, 0x00, 0x00, 0x00 },		// Hours units
+	{ 0x00, 0x01, 0xf8, 0x00, 0x00, 0x00 },		// Minutes tens
+	{ 0x00, 0x00, 0x07, 0xfe, 0x00, 0x00 },		// Minutes units
+	{ 0x00, 0x00, 0x00, 0x01, 0xfc, 0x00 },		// Seconds tens
+	{ 0x00, 0x00, 0x00, 0x00, 0x03, 0xff },		// Seconds units
+};
+
+// Compose a full frame from the three field values. No range check performed.
+// 0 <= hours <= 23, 0 <= minutes <= 59, 0 <= seconds <= 60
+void composeNixies(volatile uint8_t *frame, uint8_t hours, uint8_t minutes, uint8_t seconds) {
+	const uint8_t *h = NIXIE_HOURS_SEGMENTS[hours];
+	const uint8_t *m = NIXIE_MINUTES_SEGMENTS[minutes];
+	const uint8_t *s = NIXIE_SECONDS_SEGMENTS[seconds];
+
+	for (uint8_t i=0;  i<6;  i++) {
+		frame[i] = pgm_read_byte(h+i) | pgm_read_byte(m+i) | pgm_read_byte(s+i);
+	}
+}
+
+// Find the value a frame shows on one field, by matching it against the segment table.
+// Returns -1 when the field's bits match no value (blank, or more than one digit lit).
+int8_t decodeNixieField(const volatile uint8_t *frame, uint8_t field) {
+	const uint8_t *table;
+	uint8_t count;
+
+	switch (field) {
+		case NIXIE_HOURS:
+			table = &NIXIE_HOURS_SEGMENTS[0][0];
+			count = 24;
+			break;
+		case NIXIE_MINUTES:
+			table = &NIXIE_MINUTES_SEGMENTS[0][0];
+			count = 60;
+			break;
+		default:
+			table = &NIXIE_SECONDS_SEGMENTS[0][0];
+			count = 61;
+	}
+
+	for (uint8_t value=0;  value<count;  value++) {
+		uint8_t i;
+		for (i=0;  i<6;  i++) {
+			uint8_t bits = frame[i] & pgm_read_byte(&NIXIE_FIELD_MASKS[field][i]);
+			if (bits != pgm_read_byte(table + value*6 + i))
+				break;
+		}
+		if (i == 6)
+			return value;
+	}
+
+	return -1;
+}
+
+// Render a frame as text, "HH:MM:SS", as it would appear on the tubes. A field
+// that shows no valid value renders as "??". Text must have room for 9 characters.
+void renderNixies(const volatile uint8_t *frame, char *text) {
+	for (uint8_t field=0;  field<3;  field++) {
+		int8_t value = decodeNixieField(frame, field);
+		char *digits = text + field*3;
+
+		if (value < 0) {
+			digits[0] = '?';
+			digits[1] = '?';
+		}
+		else {
+			// Hours tens digit is suppressed when zero.
+			if (field == NIXIE_HOURS  &&  value < 10)
+				digits[0] = ' ';
+			else
+				digits[0] = '0' + value / 10;
+			digits[1] = '0' + value % 10;
+		}
+
+		digits[2] = (field < 2) ? ':' : '\0';
+	}
+}
@@ -0,0 +1,40 @@
+#ifndef NixieSegments_h
+#define NixieSegments_h
+
+#include <Arduino.h>
+
+#ifndef PROGMEM
+	// Host build: tables live in ordinary memory.
+	#define PROGMEM
+	#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#endif
+
+// Fields of the nixie display.
+const uint8_t NIXIE_HOURS = 0;
+const uint8_t NIXIE_MINUTES = 1;
+const uint8_t NIXIE_SECONDS = 2;
+
+// Segment tables, in flash. Each row is the 6-byte frame that lights one value
+// of a field, to be ORed with the rows for the other fields.
+extern const uint8_t NIXIE_HOURS_SEGMENTS[24][6] PROGMEM;
+extern const uint8_t NIXIE_MINUTES_SEGMENTS[60][6] PROGMEM;
+extern const uint8_t NIXIE_SECONDS_SEGMENTS[61][6] PROGMEM;
+
+// All the bits belonging to each field.
+extern const uint8_t NIXIE_FIELD_MASKS[3][6] PROGMEM;
+
+// Cathodes wired to the drivers, by tube (hours tens first) and digit. Each entry is
+// a bit index into the frame (byte * 8 + bit), or NIXIE_NO_CATHODE.
+const uint8_t NIXIE_TUBES = 6;
+const uint8_t NIXIE_CATHODES = 48;
+const uint8_t NIXIE_NO_CATHODE = 0xff;
+extern const uint8_t NIXIE_TUBE_CATHODES[NIXIE_TUBES][10] PROGMEM;
+
+// All the bits belonging to each tube.
+extern const uint8_t NIXIE_TUBE_MASKS[NIXIE_TUBES][6] PROGMEM;
+
+void composeNixies(volatile uint8_t *frame, uint8_t hours, uint8_t minutes, uint8_t seconds);
+int8_t decodeNixieField(const volatile uint8_t *frame, uint8_t field);
+void renderNixies(const volatile uint8_t *frame, char *text);
+
+#endif
@@ -0,0 +1,168 @@
+#include "PixelChain.h"
+
+PixelChain::PixelChain(uint8_t *b, uint8_t c, volatile uint8_t *p, uint8_t m,
+		const uint8_t *ends, uint8_t segments) {
+	buffer = b;
+	count = c;
+	port = p;
+	mask = m;
+	segmentEnds = ends;
+	segmentCount = segments;
+	restarts = 0;
+
+	for (uint16_t i=0;  i<(uint16_t)count*3;  i++)
+		buffer[i] = 0;
+
+	// Send the whole chain on the first show().
+	dirty = ((uint32_t)1 << segmentCount) - 1;
+}
+
+// The data pin must already be an output.
+void PixelChain::begin() {
+	*port &= ~mask;
+}
+
+// Send the changed part of the chain. Returns false if it couldn't get a frame through;
+// the changes stay pending for the next call.
+bool PixelChain::show() {
+	if (dirty == 0)
+		return true;
+
+	for (uint8_t attempt=0;  attempt<maxAttempts;  attempt++) {
+		if (send()) {
+			dirty = 0;
+			return true;
+		}
+
+		restarts++;
+
+		// Let the partial frame latch, so the next attempt starts at the first pixel.
+		delayMicroseconds(300);
+	}
+
+	return false;
+}
+
+// Send segments up to the last dirty one. Returns false if an interrupt held the line
+// idle long enough for the pixels to latch part way.
+bool PixelChain::send() {
+	uint8_t last = 0;
+	for (uint8_t segment=0;  segment<segmentCount;  segment++) {
+		if (dirty & ((uint16_t)1 << segment))
+			last = segment;
+	}
+
+	uint8_t oldSREG = SREG;
+	uint8_t start = 0;
+	bool complete = true;
+
+	for (uint8_t segment=0;  segment<=last;  segment++) {
+		uint8_t end = segmentEnds[segment];
+
+		cli();
+		sendBytes(&buffer[start * 3], (uint16_t)(end - start) * 3);
+		uint16_t sent = TCNT1;
+
+		if (segment == last)
+			break;
+
+		// Window for pending interrupts, held open for windowCounts so that all of them
+		// get a turn, not just the first. TCNT1 is read with interrupts off, since an ISR
+		// that reads it between the two bytes would clobber the high byte. Timer1
+		// wrapping means the tick ISR could have run, so it ends the window at once.
+		uint16_t now;
+		do {
+			sei();
+			asm volatile("nop");
+			cli();
+			now = TCNT1;
+		} while (now >= sent  &&  now - sent < windowCounts);
+
+		if (now < sent  ||  now - sent > resetMarginCounts) {
+			complete = false;
+			break;
+		}
+
+		start = end;
+	}
+
+	SREG = oldSREG;
+	return complete;
+}
+
+void PixelChain::setPixelColor(uint8_t n, uint32_t color) {
+	uint8_t *p = &buffer[n * 3];
+	uint8_t r = color >> 16;
+	uint8_t g = color >> 8;
+	uint8_t b = color;
+
+	if (p[0] == g  &&  p[1] == r  &&  p[2] == b)
+		return;
+
+	p[0] = g;
+	p[1] = r;
+	p[2] = b;
+
+	uint8_t segment = 0;
+	while (segment < segmentCount-1  &&  n >= segmentEnds[segment])
+		segment++;
+	dirty |= (uint16_t)1 << segment;
+}
+
+uint32_t PixelChain::getPixelColor(uint8_t n) {
+	uint8_t *p = &buffer[n * 3];
+	return ((uint32_t)p[1] << 16) | ((uint32_t)p[0] << 8) | p[2];
+}
+
+// Frames sent again because an interrupt ran too long between segments.
+uint8_t PixelChain::getRestarts() {
+	return restarts;
+}
+
+// Send bytes, MSB first. Call with interrupts disabled. Each bit is 20 cycles (1.25us):
+// high for 5 (zero) or 13 (one) of them. This is the 16MHz 800kHz loop from
+// Adafruit_NeoPixel.
+void PixelChain::sendBytes(const uint8_t *bytes, uint16_t length) {
+#ifdef __AVR__
+	volatile uint8_t *p = port;
+	const uint8_t *ptr = bytes;
+	uint8_t hi = *p | mask;
+	uint8_t lo = *p & ~mask;
+	uint8_t next = lo;
+	uint8_t bit = 8;
+	uint8_t b = *ptr++;
+	uint16_t i = length;
+
+	asm volatile(
+		"1:"							"\n\t"	// Clk  Pseudocode		(T =  0)
+		"st   %a[port],  %[hi]"			"\n\t"	// 2    PORT = hi		(T =  2)
+		"sbrc %[byte],  7"				"\n\t"	// 1-2  if(b & 128)
+		 "mov  %[next], %[hi]"			"\n\t"	// 0-1   next = hi		(T =  4)
+		"dec  %[bit]"					"\n\t"	// 1    bit--			(T =  5)
+		"st   %a[port],  %[next]"		"\n\t"	// 2    PORT = next		(T =  7)
+		"mov  %[next] ,  %[lo]"			"\n\t"	// 1    next = lo		(T =  8)
+		"breq 2f"						"\n\t"	// 1-2  if(bit == 0) (from dec above)
+		"rol  %[byte]"					"\n\t"	// 1    b <<= 1			(T = 10)
+		"rjmp .+0"						"\n\t"	// 2    nop nop			(T = 12)
+		"nop"							"\n\t"	// 1    nop				(T = 13)
+		"st   %a[port],  %[lo]"			"\n\t"	// 2    PORT = lo		(T = 15)
+		"nop"							"\n\t"	// 1    nop				(T = 16)
+		"rjmp .+0"						"\n\t"	// 2    nop nop			(T = 18)
+		"rjmp 1b"						"\n\t"	// 2    -> next bit		(T = 20)
+		"2:"							"\n\t"	//						(T = 10)
+		"ldi  %[bit]  ,  8"				"\n\t"	// 1    bit = 8			(T = 11)
+		"ld   %[byte] ,  %a[ptr]+"		"\n\t"	// 2    b = *ptr++		(T = 13)
+		"st   %a[port], %[lo]"			"\n\t"	// 2    PORT = lo		(T = 15)
+		"nop"							"\n\t"	// 1    nop				(T = 16)
+		"sbiw %[count], 1"				"\n\t"	// 2    i--				(T = 18)
+		"brne 1b"						"\n"	// 2    if(i != 0) -> next byte	(T = 20)
+		: [port]  "+e" (p),
+		  [byte]  "+r" (b),
+		  [bit]   "+r" (bit),
+		  [next]  "+r" (next),
+		  [count] "+w" (i),
+		  [ptr]   "+e" (ptr)
+		: [hi]    "r" (hi),
+		  [lo]    "r" (lo));
+#endif
+}
@@ -0,0 +1,67 @@
+#ifndef PixelChain_h
+#define PixelChain_h
+
+#include <Arduino.h>
+
+// Driver for a chain of WS2812 pixels at 800kHz, on a 16MHz AVR.
+//
+// The chain is split into up to 16 segments, and show() sends one segment at
+// a time with interrupts disabled, opening a window of windowCounts between segments in
+// which pending interrupts can run. Short segments keep the interrupt latency down: each
+// pixel takes 30us. The pixels latch their data when the line is idle for their reset
+// time, so a gap longer than resetMarginCounts would latch a partial frame, and the next
+// segment would land at the start of the chain. When that happens the frame is sent
+// again from the start, after a full reset.
+//
+// Only segments up to the last one that changed are sent: pixels further along the chain
+// keep what they have.
+//
+// Colors are packed 0xRRGGBB, as from Adafruit_NeoPixel::Color(). The buffer holds the
+// wire format, GRB, three bytes per pixel.
+class PixelChain {
+
+	public:
+		// Longest gap between segments, in Timer1 counts (0.5us). WS2812B parts hold
+		// their data for gaps of under 50us.
+		static const uint16_t resetMarginCounts = 60;
+
+		// Time the window between segments stays open, in Timer1 counts. Every pending
+		// interrupt runs in it, and a short one like the SPI transfer interrupt can run
+		// several times over. The rest of resetMarginCounts is left for the last one to
+		// finish.
+		static const uint16_t windowCounts = 30;
+
+		// Attempts at a frame before leaving it for the next show()
+		static const uint8_t maxAttempts = 3;
+
+		PixelChain(uint8_t *buffer, uint8_t count, volatile uint8_t *port, uint8_t mask,
+				const uint8_t *segmentEnds, uint8_t segmentCount);
+
+		void begin();
+		bool show();
+
+		void setPixelColor(uint8_t n, uint32_t color);
+		uint32_t getPixelColor(uint8_t n);
+
+		uint8_t getRestarts();
+
+	private:
+		uint8_t *buffer;
+		uint8_t count;
+		volatile uint8_t *port;
+		uint8_t mask;
+
+		// Index of the pixel after the end of each segment
+		const uint8_t *segmentEnds;
+		uint8_t segmentCount;
+
+		// Bit n set when segment n has changed since it was last sent
+		uint16_t dirty;
+
+		uint8_t restarts;
+
+		bool send();
+		void sendBytes(const uint8_t *bytes, uint16_t length);
+};
+
+#endif
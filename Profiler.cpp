@@ -0,0 +1,62 @@
+#include "Profiler.h"
+
+Profiler::Profiler(Segment *s, uint8_t c) {
+	segments = s;
+	count = c;
+	for (uint8_t i=0;  i<count;  i++)
+		reset(i);
+}
+
+void Profiler::record(uint8_t segment, uint16_t counts) {
+	Segment *s = &segments[segment];
+
+	s->count++;
+	s->total += counts;
+	if (counts < s->min)
+		s->min = counts;
+	if (counts > s->max)
+		s->max = counts;
+
+	uint8_t bucket = 0;
+	while (counts) {
+		counts >>= 1;
+		bucket++;
+	}
+	if (s->histogram[bucket] != 0xffff)
+		s->histogram[bucket]++;
+}
+
+// Copy out a segment's statistics, without the ISR changing them part way.
+void Profiler::read(uint8_t segment, Segment *copy) {
+	uint8_t oldSREG = SREG;
+	cli();
+	*copy = segments[segment];
+	SREG = oldSREG;
+}
+
+void Profiler::reset(uint8_t segment) {
+	uint8_t oldSREG = SREG;
+	cli();
+
+	Segment *s = &segments[segment];
+	s->count = 0;
+	s->total = 0;
+	s->min = 0xffff;
+	s->max = 0;
+	for (uint8_t i=0;  i<buckets;  i++)
+		s->histogram[i] = 0;
+
+	SREG = oldSREG;
+}
+
+uint8_t Profiler::getCount() {
+	return count;
+}
+
+// Counts between two readings of TCNT1 within a tick, allowing for one wrap at the
+// compare match. top is OCR1A for the tick.
+uint16_t Profiler::elapsed(uint16_t start, uint16_t end, uint16_t top) {
+	if (end >= start)
+		return end - start;
+	return end + (top + 1 - start);
+}
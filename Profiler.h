@@ -0,0 +1,42 @@
+#ifndef Profiler_h
+#define Profiler_h
+
+#include <Arduino.h>
+
+// Run times of code segments, in Timer1 counts (0.5us). Each segment keeps its shortest,
+// longest and mean time, and a histogram with a bucket per power of two: bucket 0 for a
+// time of 0, and bucket n for 2^(n-1) up to 2^n - 1 counts. Bucket counts stop at 65535,
+// and the total for the mean wraps after 2^32 counts (36 minutes of run time), so reset
+// a busy segment now and then.
+//
+// record() is cheap enough for the tick ISR. A segment is recorded either in the ISR or
+// in the main loop, not both; read() and reset() may be called from the main loop with
+// interrupts enabled.
+class Profiler {
+
+	public:
+		static const uint8_t buckets = 17;
+
+		struct Segment {
+			uint32_t count;
+			uint32_t total;
+			uint16_t min;
+			uint16_t max;
+			uint16_t histogram[buckets];
+		};
+
+		Profiler(Segment *segments, uint8_t count);
+
+		void record(uint8_t segment, uint16_t counts);
+		void read(uint8_t segment, Segment *copy);
+		void reset(uint8_t segment);
+		uint8_t getCount();
+
+		static uint16_t elapsed(uint16_t start, uint16_t end, uint16_t top);
+
+	private:
+		Segment *segments;
+		uint8_t count;
+};
+
+#endif
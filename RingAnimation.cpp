@@ -0,0 +1,117 @@
+#include "RingAnimation.h"
+
+RingAnimation::RingAnimation() {
+	sequence = NULL;
+	position = NULL;
+	loop = false;
+	countdown = 0;
+	opaque = 0;
+
+	for (uint8_t i=0;  i<sizeof(overlay);  i++)
+		overlay[i] = 0;
+	for (uint8_t i=0;  i<sizeof(dirty);  i++)
+		dirty[i] = 0;
+}
+
+// Start an animation, replacing the one playing. Its first keyframe is drawn on the
+// next step(). The new animation starts from the old one's overlay, so it should begin
+// with a fill if it needs a clean ring.
+void RingAnimation::play(const uint8_t *newSequence, bool newLoop) {
+	sequence = newSequence;
+	position = newSequence;
+	loop = newLoop;
+	countdown = 1;
+}
+
+// Stop the animation and clear its overlay.
+void RingAnimation::stop() {
+	sequence = NULL;
+	position = NULL;
+	countdown = 0;
+
+	if (opaque == 0)
+		return;
+
+	for (uint8_t pixel=0;  pixel<pixels;  pixel++)
+		setIndex(pixel, 0);
+}
+
+// Advance one tick. Returns true when the overlay changed.
+bool RingAnimation::step() {
+	if (position == NULL  ||  --countdown > 0)
+		return false;
+
+	uint8_t ticks = pgm_read_byte(position++);
+	if (ticks == 0) {
+		if (!loop) {
+			stop();
+			return true;
+		}
+
+		position = sequence;
+		ticks = pgm_read_byte(position++);
+	}
+
+	countdown = ticks;
+
+	uint8_t count = pgm_read_byte(position++);
+	for (uint8_t i=0;  i<count;  i++) {
+		uint8_t pixel = pgm_read_byte(position++);
+		uint8_t index = pgm_read_byte(position++);
+
+		if (pixel == fill) {
+			for (uint8_t p=0;  p<pixels;  p++)
+				setIndex(p, index);
+		}
+		else
+			setIndex(pixel, index);
+	}
+
+	return count > 0;
+}
+
+// Is this animation the one playing?
+bool RingAnimation::isPlaying(const uint8_t *s) {
+	return position != NULL  &&  sequence == s;
+}
+
+// Is anything playing or still drawn?
+bool RingAnimation::isActive() {
+	return position != NULL  ||  opaque > 0;
+}
+
+// Palette index of a ring pixel, 0 when transparent.
+uint8_t RingAnimation::getIndex(uint8_t pixel) {
+	uint8_t packed = overlay[pixel >> 1];
+	return (pixel & 0x01) ? packed >> 4 : packed & 0x0f;
+}
+
+// Returns true if the pixel changed since the last call, and clears its flag.
+bool RingAnimation::takeDirty(uint8_t pixel) {
+	uint8_t bit = 1 << (pixel & 0x07);
+	if (dirty[pixel >> 3] & bit) {
+		dirty[pixel >> 3] &= ~bit;
+		return true;
+	}
+
+	return false;
+}
+
+void RingAnimation::setIndex(uint8_t pixel, uint8_t index) {
+	uint8_t old = getIndex(pixel);
+	if (old == index)
+		return;
+
+	if (old == 0)
+		opaque++;
+	else if (index == 0)
+		opaque--;
+
+	uint8_t *packed = &overlay[pixel >> 1];
+	if (pixel & 0x01)
+		*packed = (*packed & 0x0f) | (index << 4);
+	else
+		*packed = (*packed & 0xf0) | index;
+
+	dirty[pixel >> 3] |= 1 << (pixel & 0x07);
+}
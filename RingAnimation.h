@@ -0,0 +1,60 @@
+#ifndef RingAnimation_h
+#define RingAnimation_h
+
+#include <Arduino.h>
+
+#ifndef PROGMEM
+	// Host build: tables live in ordinary memory.
+	#define PROGMEM
+	#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#endif
+
+// Plays keyframed animations over the 60 pixel ring, from program memory. Animations are
+// generated by tools/animations.py, which describes the format. Each keyframe only lists
+// the pixels that change, and the player only touches those.
+//
+// The animation is kept as an overlay of palette indices, two pixels to a byte. Index 0
+// is transparent, so the live display shows through wherever the animation isn't drawing.
+class RingAnimation {
+
+	public:
+		static const uint8_t pixels = 60;
+		static const uint8_t fill = 0xff;
+
+		RingAnimation();
+
+		void play(const uint8_t *sequence, bool loop);
+		void stop();
+		bool step();
+
+		bool isPlaying(const uint8_t *sequence);
+		bool isActive();
+		uint8_t getIndex(uint8_t pixel);
+		bool takeDirty(uint8_t pixel);
+
+	private:
+		const uint8_t *sequence;
+		const uint8_t *position;
+		bool loop;
+		uint8_t countdown;
+
+		// Number of pixels with a non-transparent index
+		uint8_t opaque;
+
+		uint8_t overlay[pixels / 2];
+
+		// Bit set for each pixel whose index changed since takeDirty()
+		uint8_t dirty[(pixels + 7) / 8];
+
+		void setIndex(uint8_t pixel, uint8_t index);
+};
+
+const uint8_t ANIMATION_PALETTE_SIZE = 8;
+
+extern const uint8_t ANIMATION_PALETTE[ANIMATION_PALETTE_SIZE][3] PROGMEM;
+
+extern const uint8_t ANIMATION_FIX_FLASH[] PROGMEM;
+extern const uint8_t ANIMATION_ACQUISITION_SPINNER[] PROGMEM;
+extern const uint8_t ANIMATION_MINUTE_TRANSITION[] PROGMEM;
+
+#endif
@@ -0,0 +1,97 @@
+#include "Scheduler.h"
+
+Scheduler::Scheduler(Task *tasks, uint8_t count, uint32_t (*cycleClock)()) {
+	this->tasks = tasks;
+	this->count = count;
+	this->cycleClock = cycleClock;
+
+	for (uint8_t i=0;  i<count;  i++) {
+		tasks[i].countdown = tasks[i].periodTicks;
+		tasks[i].due = false;
+		tasks[i].released = false;
+	}
+	resetStats();
+}
+
+// Count down the periodic tasks. Invoked from the tick ISR.
+void Scheduler::tick() {
+	for (uint8_t i=0;  i<count;  i++) {
+		Task *task = &tasks[i];
+		if (task->periodTicks == 0)
+			continue;
+
+		if (--task->countdown == 0) {
+			task->countdown = task->periodTicks;
+			task->due = true;
+		}
+	}
+}
+
+// Notice newly released tasks, then run the most urgent one. Returns false when
+// no task was ready.
+bool Scheduler::runNext() {
+	uint32_t now = cycleClock();
+	Task *next = NULL;
+
+	for (uint8_t i=0;  i<count;  i++) {
+		Task *task = &tasks[i];
+
+		if (!task->released) {
+			if (task->due  ||  (task->flag != NULL  &&  *task->flag)) {
+				task->released = true;
+				task->releasedAt = now;
+			}
+			else
+				continue;
+		}
+
+		if (next == NULL  ||  task->priority < next->priority)
+			next = task;
+	}
+
+	if (next == NULL)
+		return false;
+
+	// Clear the release before running, so a release arriving during the run is not lost.
+	next->released = false;
+	next->due = false;
+	if (next->flag != NULL)
+		*next->flag = false;
+
+	uint32_t start = cycleClock();
+	next->run();
+	uint32_t end = cycleClock();
+
+	uint32_t elapsed = end - start;
+	uint32_t latency = end - next->releasedAt;
+
+	next->runCount++;
+	next->totalCycles += elapsed;
+	if (elapsed > next->maxCycles)
+		next->maxCycles = elapsed;
+	if (latency > next->maxLatencyCycles)
+		next->maxLatencyCycles = latency;
+	if (next->deadlineCycles != 0  &&  latency > next->deadlineCycles)
+		next->deadlineMisses++;
+
+	return true;
+}
+
+// Clear the runtime accounting of all tasks.
+void Scheduler::resetStats() {
+	for (uint8_t i=0;  i<count;  i++) {
+		tasks[i].runCount = 0;
+		tasks[i].totalCycles = 0;
+		tasks[i].maxCycles = 0;
+		tasks[i].maxLatencyCycles = 0;
+		tasks[i].deadlineMisses = 0;
+	}
+}
+
+uint8_t Scheduler::getCount() {
+	return count;
+}
+
+Task *Scheduler::getTask(uint8_t index) {
+	return &tasks[index];
+}
@@ -0,0 +1,54 @@
+#ifndef Scheduler_h
+#define Scheduler_h
+
+#include <Arduino.h>
+
+// Body of a scheduled task.
+typedef void (*TaskFunction)();
+
+// One entry of a static task table. A task is released when its flag is set
+// (typically from an ISR), or every periodTicks ticks, or both. The flag is
+// cleared just before the task runs. Among released tasks, the one with the
+// lowest priority value runs first.
+struct Task {
+	const char *name;			// In flash
+	TaskFunction run;
+	volatile bool *flag;		// Release flag, or NULL for a purely periodic task
+	uint16_t periodTicks;		// Release period in ticks, or 0 for a purely event-driven task
+	uint8_t priority;			// 0 is most urgent
+	uint32_t deadlineCycles;	// Allowed cycles from release to completion, or 0 for none
+
+	// Maintained by the scheduler
+	volatile bool due;			// Set by tick() when the period elapses
+	uint16_t countdown;			// Ticks until the next periodic release
+	bool released;
+	uint32_t releasedAt;		// Cycle count when the release was noticed
+	uint32_t runCount;
+	uint32_t totalCycles;		// Sum of run times, for computing the mean
+	uint32_t maxCycles;			// Longest single run
+	uint32_t maxLatencyCycles;	// Longest time from release to completion
+	uint16_t deadlineMisses;
+};
+
+// Cooperative, non-preemptive scheduler over a static task table. Call tick() from
+// the tick ISR, and runNext() repeatedly from loop(). Each task's run time is
+// measured in CPU cycles, using the supplied clock.
+class Scheduler {
+
+	public:
+		Scheduler(Task *tasks, uint8_t count, uint32_t (*cycleClock)());
+
+		void tick();
+		bool runNext();
+		void resetStats();
+
+		uint8_t getCount();
+		Task *getTask(uint8_t index);
+
+	private:
+		Task *tasks;
+		uint8_t count;
+		uint32_t (*cycleClock)();
+};
+
+#endif
@@ -1,3 +1,6 @@
+#ifndef ScoreBoard_h
+#define ScoreBoard_h
+
 #include <Arduino.h>
 
 // A scoreboard keeps a history of the last n scores, and
@@ -18,4 +21,6 @@ class ScoreBoard {
 		
 	private:
 		uint8_t slots[size];
-};
\ No newline at end of file
+};
+
+#endif
@@ -0,0 +1,68 @@
+#include "StackMonitor.h"
+
+#ifdef __AVR__
+
+const uint8_t STACK_PAINT = 0xc5;
+
+// From the linker: the end of the static data, and the top of SRAM.
+extern uint8_t _end;
+extern uint8_t __stack;
+
+// Runs in .init1, before anything is on the stack. Only registers are used.
+void paintStack() __attribute__((naked, used, section(".init1")));
+void paintStack() {
+	__asm__ __volatile__ (
+		"	ldi r30, lo8(_end)\n"
+		"	ldi r31, hi8(_end)\n"
+		"	ldi r24, %0\n"
+		"	ldi r25, hi8(__stack)\n"
+		"	rjmp 2f\n"
+		"1:	st Z+, r24\n"
+		"2:	cpi r30, lo8(__stack)\n"
+		"	cpc r31, r25\n"
+		"	brlo 1b\n"
+		: : "i" (STACK_PAINT) : "r24", "r25", "r30", "r31");
+}
+
+// Bytes of .data, .bss and .noinit.
+uint16_t staticDataSize() {
+	return &_end - (uint8_t *)RAMSTART;
+}
+
+// Bytes from the end of the static data to the top of SRAM, for the stack.
+uint16_t stackRegionSize() {
+	return &__stack + 1 - &_end;
+}
+
+// Most bytes of stack used so far: the region less the paint that is left at its bottom.
+uint16_t stackHighWater() {
+	const uint8_t *p = &_end;
+	while (p <= &__stack  &&  *p == STACK_PAINT)
+		p++;
+	return &__stack + 1 - p;
+}
+
+// Bytes between the end of the static data and the stack pointer now.
+uint16_t stackFree() {
+	return (uint8_t *)SP - &_end;
+}
+
+#else
+
+uint16_t staticDataSize() {
+	return 0;
+}
+
+uint16_t stackRegionSize() {
+	return 0;
+}
+
+uint16_t stackHighWater() {
+	return 0;
+}
+
+uint16_t stackFree() {
+	return 0;
+}
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef StackMonitor_h
+#define StackMonitor_h
+
+#include <Arduino.h>
+
+// SRAM use. Before the C runtime starts, the SRAM above the static data (.data, .bss and
+// .noinit) is painted with a pattern. The stack wears the paint away as it grows down,
+// so the paint left shows how close the stack has come to the static data. Nothing
+// uses the heap; malloc() would spoil the count.
+//
+// On a host build, there is no paint and the sizes are 0.
+uint16_t staticDataSize();
+uint16_t stackRegionSize();
+uint16_t stackHighWater();
+uint16_t stackFree();
+
+#endif
@@ -0,0 +1,470 @@
+#include "WwvbDecoder.h"
+
+// Correlation template for a zero bit, including the trailing 0s of the preceding symbol,
+// and the leading 1s of the following symbol. From head end to tail end:
+// 10 zeroes, 12 ones, 48 zeroes, 10 ones.  Initialzing values start with LSB, which
+// is the most recent bit (the tail end of the pulse), and progress to
+// the oldest bit (the head end).  (Bytes are written LSB first, but bits in a byte are
+// MSB first!  If you get confused, print this out and read it in a mirror.)
+const uint8_t WwvbDecoder::patternZero[10] PROGMEM = { 0xff, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0xfc, 0x3f, 0x00 };
+// Correlaton template for one bit. From head to tail:
+// 10 zeroes, 30 ones, 30 zeroes, 10 ones
+const uint8_t WwvbDecoder::patternOne[10] PROGMEM = { 0xff, 0x03, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0x3f, 0x00 };
+// Correlation template for marker bit. From head to tail:
+// 10 zeroes, 48 oness, 12 zeroes, 10 ones
+const uint8_t WwvbDecoder::patternMarker[10] PROGMEM = { 0xff, 0x03, 0xc0, 0xff, 0xff, 0xff, 0xff, 0xff, 0x3f, 0x00 };
+
+WwvbDecoder::WwvbDecoder() {
+	scoreThreshold = 70;
+	detectedSymbolThreshold = 10;
+	missedSymbolThreshold = 6;
+
+	for (uint8_t i = 0;  i < 10;  i++)
+		samples[i] = 0;
+	memset(stream, 0, sizeof(stream));
+	memset(margins, 0, sizeof(margins));
+
+	mode = MODE_SEEK;
+	detectedSymbolCount = 0;
+	peekCountdown = 60;
+	missedSymbolCount = 0;
+
+	symbol = 0;
+	peakScore = 0;
+	margin = 0;
+	offset = 0;
+}
+
+// Shift in a sample, and score the samples against each pattern. Invoked at 60Hz.
+void WwvbDecoder::correlate(uint8_t sample) {
+	shiftSample(sample);
+	zero.shiftScore(score(patternZero));
+	one.shiftScore(score(patternOne));
+	marker.shiftScore(score(patternMarker));
+}
+
+// Look for a symbol in the scoreboards, after each correlate(). Returns EVENT_* bits for
+// what happened.
+uint8_t WwvbDecoder::decode() {
+	if (mode == MODE_SEEK)
+		return seek();
+	return sync();
+}
+
+// Change the operating mode, resetting its state.
+void WwvbDecoder::setMode(uint8_t newMode) {
+	switch (newMode) {
+		case MODE_SEEK:
+			detectedSymbolCount = 0;
+			break;
+
+		case MODE_SYNC:
+			peekCountdown = 60;
+			missedSymbolCount = 0;
+			break;
+	}
+
+	mode = newMode;
+}
+
+uint8_t WwvbDecoder::getMode() {
+	return mode;
+}
+
+char WwvbDecoder::getSymbol() {
+	return symbol;
+}
+
+uint8_t WwvbDecoder::getPeakScore() {
+	return peakScore;
+}
+
+uint8_t WwvbDecoder::getMargin() {
+	return margin;
+}
+
+int8_t WwvbDecoder::getOffset() {
+	return offset;
+}
+
+const char *WwvbDecoder::getStream() {
+	return stream;
+}
+
+ScoreBoard *WwvbDecoder::getScoreBoard(uint8_t pattern) {
+	if (pattern == 0)
+		return &zero;
+	if (pattern == 1)
+		return &one;
+	return &marker;
+}
+
+uint8_t WwvbDecoder::getSample(uint8_t index) {
+	return samples[index];
+}
+
+// In MODE_SEEK: look for multiple successful symbols. We see a symbol when one of the
+// scoreboards shows a peak value in the center slot. No attempt to detect missing
+// symbols. When we hit the threshold, switch to MODE_SYNC.
+uint8_t WwvbDecoder::seek() {
+	uint8_t detectedScore;
+	uint8_t peakIndex;
+	uint8_t events = 0;
+
+	char detectedSymbol = 0;
+
+	// A successful bit has peak in the middle slot. When the peak is elsewhere, ignore it.
+	if (zero.maxOverThreshold(scoreThreshold, &detectedScore, &peakIndex)) {
+		if (peakIndex == ScoreBoard::centerIndex) detectedSymbol = '0';
+	}
+	else if (one.maxOverThreshold(scoreThreshold, &detectedScore, &peakIndex)) {
+		if (peakIndex == ScoreBoard::centerIndex) detectedSymbol = '1';
+	}
+	else if (marker.maxOverThreshold(scoreThreshold, &detectedScore, &peakIndex)) {
+		if (peakIndex == ScoreBoard::centerIndex) detectedSymbol = 'M';
+	}
+
+	// Any symbol seen?
+	if (detectedSymbol != 0) {
+		detectedSymbolCount++;
+		events = found(detectedSymbol, detectedScore, peakIndex);
+	}
+
+	// Enough symbols in a row?
+	if (detectedSymbolCount >= detectedSymbolThreshold) {
+		// Commence syncin' proper.
+		setMode(MODE_SYNC);
+		events |= EVENT_MODE;
+	}
+	return events;
+}
+
+// In MODE_SYNC: let 60 (+- offset) ticks elapse, and look for a symbol match. A peak in
+// the middle slot is right on time; a peak in a different slot means the local oscillator
+// is running fast or slow compared to the reference, and the offset says by how much.
+// If we hit a threshold of missed symbols, switch back to MODE_SEEK.
+uint8_t WwvbDecoder::sync() {
+	if (--peekCountdown > 0)
+		return 0;
+
+	// Look for next symbol.
+	uint8_t detectedScore = 0;
+	uint8_t peakIndex = ScoreBoard::centerIndex;
+
+	char detectedSymbol = 0;
+
+	if (zero.maxOverThreshold(scoreThreshold, &detectedScore, &peakIndex)) {
+		detectedSymbol = '0';
+	}
+	else if (one.maxOverThreshold(scoreThreshold, &detectedScore, &peakIndex)) {
+		detectedSymbol = '1';
+	}
+	else if (marker.maxOverThreshold(scoreThreshold, &detectedScore, &peakIndex)) {
+		detectedSymbol = 'M';
+	}
+	else {
+		// No symbol seen.
+		symbol = '-';
+		peakScore = 0;
+		margin = 0;
+		offset = 0;
+		uint8_t events = shiftSymbol('-', 0);
+		if (++missedSymbolCount >= missedSymbolThreshold) {
+			// Sync lost.
+			setMode(MODE_SEEK);
+			return events | EVENT_MODE;
+		}
+
+		// Try again next second.
+		peekCountdown = 60;
+		return events;
+	}
+
+	// Saw a symbol.
+	missedSymbolCount = 0;
+
+	// Positive offset means the local clock is running fast (interval value too small);
+	// negative offset means it's running slow (interval too big). Next time, peek when
+	// the next symbol should be centered again.
+	uint8_t events = found(detectedSymbol, detectedScore, peakIndex);
+	offset = ScoreBoard::centerIndex - peakIndex;
+	peekCountdown = 60 + offset;
+	return events;
+}
+
+// Record a detected symbol, and shift it into the stream.
+uint8_t WwvbDecoder::found(char detectedSymbol, uint8_t detectedScore, uint8_t peakIndex) {
+	symbol = detectedSymbol;
+	peakScore = detectedScore;
+	margin = symbolMargin(detectedSymbol, detectedScore, peakIndex);
+	offset = 0;
+	return shiftSymbol(detectedSymbol, margin);
+}
+
+// How far a detected symbol's peak score stands above the other two patterns' scores
+// in the same slot.
+uint8_t WwvbDecoder::symbolMargin(char detectedSymbol, uint8_t detectedScore, uint8_t peakIndex) {
+	uint8_t zeroScore = zero.getSlotValue(peakIndex);
+	uint8_t oneScore = one.getSlotValue(peakIndex);
+	uint8_t markerScore = marker.getSlotValue(peakIndex);
+	uint8_t other;
+
+	switch (detectedSymbol) {
+		case '0':
+			other = oneScore > markerScore ? oneScore : markerScore;
+			break;
+		case '1':
+			other = zeroScore > markerScore ? zeroScore : markerScore;
+			break;
+		default:
+			other = zeroScore > oneScore ? zeroScore : oneScore;
+			break;
+	}
+	return detectedScore > other ? detectedScore - other : 0;
+}
+
+// Shift a symbol into the stream, scoring the stream on its resemblance to a frame on
+// the way. Returns EVENT_SYMBOL, with EVENT_FRAME when the stream holds a whole frame.
+uint8_t WwvbDecoder::shiftSymbol(char newSymbol, uint8_t newMargin) {
+	uint8_t frameScore = 0;
+
+	// Single loop for shifting and scoring. Only check that positions that should have
+	// marker symbol have them, and that non-marker positions do not.
+
+	// When markerPos = 0, we're shifting into a marker position. It gets reset to 9
+	// after processing a marker position.
+	uint8_t markerPosCountdown = 10;
+
+	for (uint8_t i=0;  i<59;  i++) {
+		markerPosCountdown--;
+		char shifted = stream[i+1];
+		stream[i] = shifted;
+		margins[i] = margins[i+1];
+		if (markerPosCountdown == 0) {
+			// Should be a marker symbol.
+			if (shifted == 'M')
+				frameScore++;
+			markerPosCountdown = 10;
+		}
+		else {
+			// Should be a 1 or 0.
+			if (shifted == '0'  ||  shifted == '1')
+				frameScore++;
+		}
+	}
+
+	// Position 0 is a marker when aligned
+	if (stream[0] == 'M')
+		frameScore++;
+
+	stream[59] = newSymbol;
+	margins[59] = newMargin;
+	if (newSymbol == 'M')
+		frameScore++;
+
+	return frameScore == 60 ? EVENT_SYMBOL | EVENT_FRAME : EVENT_SYMBOL;
+}
+
+// True when the end of the symbol stream looks like the start of a frame, up to the
+// end of the hours: markers at frame positions 59, 0, 9 and 19, and bits between, with
+// a mean margin of at least minMargin.
+bool WwvbDecoder::earlyFrameAligned(uint8_t minMargin) {
+	uint16_t marginTotal = 0;
+
+	for (uint8_t i = earlyFrameStart - 1;  i < 60;  i++) {
+		char streamSymbol = stream[i];
+		uint8_t position = i - earlyFrameStart;
+		bool isMarker = i == earlyFrameStart - 1  ||  position == 0  ||  position == 9  ||  position == 19;
+
+		if (isMarker != (streamSymbol == 'M'))
+			return false;
+		if (!isMarker  &&  streamSymbol != '0'  &&  streamSymbol != '1')
+			return false;
+		marginTotal += margins[i];
+	}
+	return marginTotal >= (uint16_t)minMargin * (60 - earlyFrameStart + 1);
+}
+
+// Minutes and hours fields of a frame, from its first symbol.
+uint8_t WwvbDecoder::frameMinutes(const char *frame) {
+	uint8_t minutes = 0;
+
+	// Symbols are stored as '0' and '1' characters; LSB for 0 symbol is 0, and LSB for 1 symbol is 1.
+	if (frame[1] & 0x01) minutes += 40;
+	if (frame[2] & 0x01) minutes += 20;
+	if (frame[3] & 0x01) minutes += 10;
+	if (frame[5] & 0x01) minutes += 8;
+	if (frame[6] & 0x01) minutes += 4;
+	if (frame[7] & 0x01) minutes += 2;
+	if (frame[8] & 0x01) minutes += 1;
+	return minutes;
+}
+
+uint8_t WwvbDecoder::frameHours(const char *frame) {
+	uint8_t hours = 0;
+
+	if (frame[12] & 0x01) hours += 20;
+	if (frame[13] & 0x01) hours += 10;
+	if (frame[15] & 0x01) hours += 8;
+	if (frame[16] & 0x01) hours += 4;
+	if (frame[17] & 0x01) hours += 2;
+	if (frame[18] & 0x01) hours += 1;
+	return hours;
+}
+
+// Decode the whole frame in the stream, after EVENT_FRAME.
+void WwvbDecoder::readFrame(FrameTime *time) {
+	time->minutes = frameMinutes(stream);
+	time->hours = frameHours(stream);
+
+	time->day = 0;
+	if (stream[22] & 0x01) time->day += 200;
+	if (stream[23] & 0x01) time->day += 100;
+	if (stream[25] & 0x01) time->day += 80;
+	if (stream[26] & 0x01) time->day += 40;
+	if (stream[27] & 0x01) time->day += 20;
+	if (stream[28] & 0x01) time->day += 10;
+	if (stream[30] & 0x01) time->day += 8;
+	if (stream[31] & 0x01) time->day += 4;
+	if (stream[32] & 0x01) time->day += 2;
+	if (stream[33] & 0x01) time->day += 1;
+
+	time->year = 2000;
+	if (stream[45] & 0x01) time->year += 80;
+	if (stream[46] & 0x01) time->year += 40;
+	if (stream[47] & 0x01) time->year += 20;
+	if (stream[48] & 0x01) time->year += 10;
+	if (stream[50] & 0x01) time->year += 8;
+	if (stream[51] & 0x01) time->year += 4;
+	if (stream[52] & 0x01) time->year += 2;
+	if (stream[53] & 0x01) time->year += 1;
+
+	time->leapYear = stream[55] & 0x01;
+
+	// 2-bit DST code
+	time->dst = 0;
+	if (stream[57] & 0x01) time->dst = 2;
+	if (stream[58] & 0x01) time->dst += 1;
+}
+
+// Shifts in a new bit sample into the array. The new bit is the LSB of the passed value.
+void WwvbDecoder::shiftSample(uint8_t value) {
+#ifdef __AVR__
+	// The asm walks the pointer through the samples, so it gets a copy of its own; the
+	// compiler may otherwise keep this in the same register, and find it moved on.
+	volatile uint8_t *p = samples;
+
+	// Assembly language for fastness.
+	asm volatile(
+
+		// Constraints at end of asm block:
+		// Output constraints:
+		// "=r" (value)		Contstraint 0: Variable "value" will be written. Use a register for it.
+		// "+e" (p)			Constraint 1: Set one of X, Y, or Z base register to p, the address of
+		//					"samples". Refer to it with %a1. It is advanced past the samples, so it
+		//					is an output as well as an input.
+		// Input constraints
+		// "0" (value)		Constraint 2: Varialbe "value" will be input to an operation. Its
+		//					location must match that used for constraint 0 (same register). Refer
+		//					to it as %2.
+
+		// Shift LSB of value into Carry flag
+		"lsr %2 \n\t"
+		
+		// Unrolled loop to shift 10 bytes.  __tmp_reg__ will be replaced with a register
+		// that can be used freely, without saving or restoring its value. %a1 refers to the
+		// pointer register selected by the compiler.
+		"ld __tmp_reg__, %a1 \n\t"
+		"rol __tmp_reg__ \n\t"
+		"st %a1+, __tmp_reg__ \n\t"
+
+		"ld __tmp_reg__, %a1 \n\t"
+		"rol __tmp_reg__ \n\t"
+		"st %a1+, __tmp_reg__ \n\t"
+
+		"ld __tmp_reg__, %a1 \n\t"
+		"rol __tmp_reg__ \n\t"
+		"st %a1+, __tmp_reg__ \n\t"
+
+		"ld __tmp_reg__, %a1 \n\t"
+		"rol __tmp_reg__ \n\t"
+		"st %a1+, __tmp_reg__ \n\t"
+
+		"ld __tmp_reg__, %a1 \n\t"
+		"rol __tmp_reg__ \n\t"
+		"st %a1+, __tmp_reg__ \n\t"
+
+		"ld __tmp_reg__, %a1 \n\t"
+		"rol __tmp_reg__ \n\t"
+		"st %a1+, __tmp_reg__ \n\t"
+
+		"ld __tmp_reg__, %a1 \n\t"
+		"rol __tmp_reg__ \n\t"
+		"st %a1+, __tmp_reg__ \n\t"
+
+		"ld __tmp_reg__, %a1 \n\t"
+		"rol __tmp_reg__ \n\t"
+		"st %a1+, __tmp_reg__ \n\t"
+
+		"ld __tmp_reg__, %a1 \n\t"
+		"rol __tmp_reg__ \n\t"
+		"st %a1+, __tmp_reg__ \n\t"
+
+		"ld __tmp_reg__, %a1 \n\t"
+		"rol __tmp_reg__ \n\t"
+		"st %a1+, __tmp_reg__ \n\t"
+
+		// See above for constraint explanation
+		// "memory": the samples are written behind the compiler's back.
+		: "=r" (value), "+e" (p) : "0" (value) : "memory"
+	);
+#else
+	// Host build: the same shift, a byte at a time.
+	uint8_t carry = value & 0x01;
+	for (uint8_t i = 0;  i < 10;  i++) {
+		uint8_t next = samples[i] >> 7;
+		samples[i] = (samples[i] << 1) | carry;
+		carry = next;
+	}
+#endif
+}
+
+
+// Array, indexed from 0..255, where each byte contains the number of 1 bits
+// in the corresponding index. Used by score function to sum the number of
+// matching bits in pattern comparisons. Kept in flash.
+static const uint8_t arity[256] PROGMEM = {
+	0,	1,	1,	2,	1,	2,	2,	3,	1,	2,	2,	3,	2,	3,	3,	4,		// 0x00..0x0f
+	1,	2,	2,	3,	2,	3,	3,	4,	2,	3,	3,	4,	3,	4,	4,	5,		// 0x10..0x1f (+1)
+	1,	2,	2,	3,	2,	3,	3,	4,	2,	3,	3,	4,	3,	4,	4,	5,		// 0x20..0x2f (+1)
+	2,	3,	3,	4,	3,	4,	4,	5,	3,	4,	4,	5,	4,	5,	5,	6,		// 0x30..0x3f (+2)
+
+	1,	2,	2,	3,	2,	3,	3,	4,	2,	3,	3,	4,	3,	4,	4,	5,		// 0x40..0x4f (+1)
+	2,	3,	3,	4,	3,	4,	4,	5,	3,	4,	4,	5,	4,	5,	5,	6,		// 0x50..0x5f (+2)
+	2,	3,	3,	4,	3,	4,	4,	5,	3,	4,	4,	5,	4,	5,	5,	6,		// 0x60..0x6f (+2)
+	3,	4,	4,	5,	4,	5,	5,	6,	4,	5,	5,	6,	5,	6,	6,	7,		// 0x70..0x7f (+3)
+
+	1,	2,	2,	3,	2,	3,	3,	4,	2,	3,	3,	4,	3,	4,	4,	5,		// 0x80..0x8f (+1)
+	2,	3,	3,	4,	3,	4,	4,	5,	3,	4,	4,	5,	4,	5,	5,	6,		// 0x90..0x9f (+2)
+	2,	3,	3,	4,	3,	4,	4,	5,	3,	4,	4,	5,	4,	5,	5,	6,		// 0xa0..0xaf (+2)
+	3,	4,	4,	5,	4,	5,	5,	6,	4,	5,	5,	6,	5,	6,	6,	7,		// 0xb0..0xbf (+3)
+
+	2,	3,	3,	4,	3,	4,	4,	5,	3,	4,	4,	5,	4,	5,	5,	6,		// 0xc0..0xcf (+2)
+	3,	4,	4,	5,	4,	5,	5,	6,	4,	5,	5,	6,	5,	6,	6,	7,		// 0xd0..0xdf (+3)
+	3,	4,	4,	5,	4,	5,	5,	6,	4,	5,	5,	6,	5,	6,	6,	7,		// 0xe0..0xef (+3)
+	4,	5,	5,	6,	5,	6,	6,	7,	5,	6,	6,	7,	6,	7,	7,	8,		// 0xf0..0xff (+4)
+};
+
+// Score the sample array bits against the supplied pattern, in flash. Result
+// is number of matching bits between them.
+uint8_t WwvbDecoder::score(const uint8_t *pattern) {
+
+	uint8_t score = 0;
+	for (uint8_t i=0; i<10; i++) {
+		// Compute matching bits: XOR pattern and samples, and complement
+		uint8_t matchingBits = ~(samples[i] ^ pgm_read_byte(&pattern[i]));
+		score += pgm_read_byte(&arity[matchingBits]);
+	}
+
+	return score;
+}
@@ -0,0 +1,135 @@
+#ifndef WwvbDecoder_h
+#define WwvbDecoder_h
+
+#include <Arduino.h>
+#include "ScoreBoard.h"
+
+#ifndef PROGMEM
+	// Host build: tables live in ordinary memory.
+	#define PROGMEM
+	#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#endif
+
+// Time carried by a WWVB frame: that at the start of the frame, with seconds 0.
+typedef struct {
+	uint8_t minutes;
+	uint8_t hours;
+	uint16_t day;			// Day of the year, from 1
+	uint16_t year;
+	bool leapYear;
+	uint8_t dst;			// 2-bit DST code: 0 not in effect, 1 ends today, 2 begins today, 3 in effect
+} FrameTime;
+
+// Decodes the WWVB receiver output, sampled at 60Hz. See the theory of operation in
+// NixieClock.ino. correlate() shifts in each sample and scores the samples against the
+// three symbol patterns; decode() looks for symbols in the scoreboards, and shifts them
+// into the symbol stream.
+//
+// In MODE_SEEK, a symbol is seen when a scoreboard peaks in its center slot. After
+// detectedSymbolThreshold of them, the decoder goes to MODE_SYNC: it peeks at the
+// scoreboards once a second, takes the peak wherever it is, and peeks next when the
+// peak should be centered again. After missedSymbolThreshold misses in a row, it goes
+// back to MODE_SEEK.
+//
+// Nothing here depends on the hardware, so the decoder also builds on a host, where
+// tools/replay runs recorded samples through it.
+class WwvbDecoder {
+
+	public:
+		// Operating modes
+		static const uint8_t MODE_SEEK = 0;
+		static const uint8_t MODE_SYNC = 1;
+
+		// Bits returned by decode()
+		static const uint8_t EVENT_SYMBOL = 0x01;		// A symbol, or a miss, was shifted into the stream
+		static const uint8_t EVENT_FRAME = 0x02;		// The stream holds a whole frame
+		static const uint8_t EVENT_MODE = 0x04;			// The decoder changed mode
+
+		// Ticks from the start of a second to the decode of the symbol before it: the
+		// patterns take in 10 samples of the following symbol, and the peak is then
+		// in the center slot.
+		static const uint8_t decodeDelayTicks = 10 + ScoreBoard::centerIndex;
+
+		// Start of the early frame check in the symbol stream: the double marker at the end
+		// of one frame and the start of the next, through the marker at the end of the hours.
+		static const uint8_t earlyFrameStart = 40;
+
+		// Correlation templates, in flash. See WwvbDecoder.cpp.
+		static const uint8_t patternZero[10];
+		static const uint8_t patternOne[10];
+		static const uint8_t patternMarker[10];
+
+		// Settings
+		uint8_t scoreThreshold;				// Pattern matching threshold
+		uint8_t detectedSymbolThreshold;	// No. of detected symbols needed to go to MODE_SYNC
+		uint8_t missedSymbolThreshold;		// No. of missed symbols in a row to go back to MODE_SEEK
+
+		WwvbDecoder();
+
+		void correlate(uint8_t sample);
+		uint8_t decode();
+
+		void setMode(uint8_t newMode);
+		uint8_t getMode();
+
+		// The symbol last shifted into the stream: '0', '1', 'M', or '-' for a miss. For
+		// a symbol, its peak score, its margin over the other patterns, and, in MODE_SYNC,
+		// how many ticks early the peak came.
+		char getSymbol();
+		uint8_t getPeakScore();
+		uint8_t getMargin();
+		int8_t getOffset();
+
+		// Decoded symbol stream. New symbols are shifted into position 59, and move
+		// toward 0, so a whole frame's symbol positions match the documentation for WWVB.
+		const char *getStream();
+		bool earlyFrameAligned(uint8_t minMargin);
+		void readFrame(FrameTime *time);
+		static uint8_t frameMinutes(const char *frame);
+		static uint8_t frameHours(const char *frame);
+
+		// Score history for a pattern: 0 for zero, 1 for one, 2 for marker.
+		ScoreBoard *getScoreBoard(uint8_t pattern);
+		uint8_t getSample(uint8_t index);
+
+		void shiftSample(uint8_t value);
+		uint8_t score(const uint8_t *pattern);
+
+	private:
+		// 80-bit long shift register for input samples.
+		// Offset 0, bit 0 has most recent sample bit; offset 9 bit 7
+		// has oldest sample bit. Shifts left.
+		volatile uint8_t samples[10];
+
+		// Score history buffers
+		ScoreBoard zero;
+		ScoreBoard one;
+		ScoreBoard marker;
+
+		volatile uint8_t mode;
+
+		// State for MODE_SEEK
+		uint8_t detectedSymbolCount;		// No. of symbols detected since entering the mode
+
+		// State for MODE_SYNC
+		uint8_t peekCountdown;				// No. of ticks to wait before peeking at the scoreboards
+		uint8_t missedSymbolCount;			// No. of consecutive symbols missed
+
+		char stream[60];
+		// Soft decisions, in step with stream: how far each symbol's score stood above the
+		// best of the other two patterns in the same slot. 0 for a missed symbol.
+		uint8_t margins[60];
+
+		char symbol;
+		uint8_t peakScore;
+		uint8_t margin;
+		int8_t offset;
+
+		uint8_t seek();
+		uint8_t sync();
+		uint8_t found(char detectedSymbol, uint8_t detectedScore, uint8_t peakIndex);
+		uint8_t symbolMargin(char detectedSymbol, uint8_t detectedScore, uint8_t peakIndex);
+		uint8_t shiftSymbol(char newSymbol, uint8_t newMargin);
+};
+
+#endif
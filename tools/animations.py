@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+# Generates Animations.cpp: the ring animations played by RingAnimation, and their palette.
+#
+# Usage: python3 tools/animations.py > Animations.cpp
+#
+# An animation is a list of keyframes. Each keyframe holds for a number of ticks, and is
+# stored as the pixels that differ from the frame before:
+#
+#	ticks, count, { pixel, palette index } * count
+#
+# ending with a keyframe of 0 ticks. Pixel FILL sets the whole ring. Palette index 0 is
+# transparent: the live display shows through.
+
+FILL = 0xff
+
+# Ring pixel at the top of the clock face
+TOP = 21
+
+PALETTE = [
+	("TRANSPARENT", (0, 0, 0)),
+	("BLACK", (0, 0, 0)),
+	("FLASH", (255, 128, 128)),
+	("FLASH_DIM", (40, 20, 20)),
+	("SPINNER", (3, 12, 6)),
+	("SPINNER_TAIL", (1, 3, 1)),
+	("SWEEP", (30, 18, 0)),
+	("SWEEP_TAIL", (6, 3, 0)),
+]
+
+INDEX = dict((name, i) for i, (name, color) in enumerate(PALETTE))
+
+
+def ring(position):
+	return (position + TOP) % 60
+
+
+def pixelName(frame, pixel):
+	return frame.get(pixel, frame.get(FILL, "TRANSPARENT"))
+
+
+# Encode a list of full frames, (ticks, {pixel: name}), as keyframe deltas. The first
+# keyframe of a looping animation also clears what the last one left behind.
+def encode(frames, loop=False):
+	out = []
+	shown = {}
+	last = frames[-1][1]
+	for ticks, frame in frames:
+		delta = []
+		if frame.get(FILL) is not None:
+			delta.append((FILL, INDEX[frame[FILL]]))
+			shown = dict((p, frame[FILL]) for p in range(60))
+		for pixel in range(60):
+			name = pixelName(frame, pixel)
+			changed = shown.get(pixel, "TRANSPARENT") != name
+			if loop and not out:
+				changed = changed or pixelName(last, pixel) != name
+			if changed:
+				delta.append((pixel, INDEX[name]))
+				shown[pixel] = name
+		out.append(ticks)
+		out.append(len(delta))
+		for pixel, index in delta:
+			out += [pixel, index]
+	out.append(0)
+	return out
+
+
+# Valid frame: flash the ring, then fade back to the live display.
+def fixFlash():
+	return encode([
+		(4, {FILL: "FLASH"}),
+		(8, {FILL: "FLASH_DIM"}),
+		(1, {FILL: "TRANSPARENT"}),
+	])
+
+
+# Waiting for a frame: a short comet going round once every two seconds.
+def acquisitionSpinner():
+	frames = []
+	for position in range(0, 60, 1):
+		frames.append((2, {
+			ring(position): "SPINNER",
+			ring(position - 1): "SPINNER_TAIL",
+		}))
+	return encode(frames, loop=True)
+
+
+# New minute: a sweep round the ring from the top, two pixels a tick.
+def minuteTransition():
+	frames = []
+	for position in range(0, 64, 2):
+		frame = {}
+		for p in (position, position + 1):
+			if p < 60:
+				frame[ring(p)] = "SWEEP"
+		for p in (position - 2, position - 1):
+			if 0 <= p < 60:
+				frame[ring(p)] = "SWEEP_TAIL"
+		frames.append((1, frame))
+	frames.append((1, {}))
+	return encode(frames)
+
+
+def array(name, data):
+	out = ["const uint8_t %s[] PROGMEM = {" % name]
+	for i in range(0, len(data), 16):
+		out.append("\t" + " ".join("%d," % b for b in data[i:i + 16]))
+	out.append("};")
+	return "\n".join(out)
+
+
+print("// Generated by tools/animations.py. Do not edit; change the script and rerun it.")
+print("")
+print('#include "RingAnimation.h"')
+print("")
+print("const uint8_t ANIMATION_PALETTE[ANIMATION_PALETTE_SIZE][3] PROGMEM = {")
+for name, color in PALETTE:
+	print("\t{ %3d, %3d, %3d },\t\t// %s" % (color + (name,)))
+print("};")
+print("")
+print(array("ANIMATION_FIX_FLASH", fixFlash()))
+print("")
+print(array("ANIMATION_ACQUISITION_SPINNER", acquisitionSpinner()))
+print("")
+print(array("ANIMATION_MINUTE_TRANSITION", minuteTransition()))
@@ -0,0 +1,381 @@
+#!/usr/bin/env python3
+# Reads and changes the clock's settings over its serial port, using the framed command
+# protocol (see CommandParser.h). Any number of clocks can be given, and the same
+# settings are applied to each.
+#
+# Usage:
+#	python3 tools/clockctl.py -p /dev/ttyUSB0 [-p /dev/ttyUSB1 ...] get [NAME ...]
+#	python3 tools/clockctl.py -p PORT ... [--save] set NAME=VALUE [NAME=VALUE ...]
+#	python3 tools/clockctl.py -p PORT ... save
+#	python3 tools/clockctl.py -p PORT ... tasks
+#	python3 tools/clockctl.py -p PORT ... [--reset] profile
+#	python3 tools/clockctl.py -p PORT ... memory
+#	python3 tools/clockctl.py -p PORT ... metrics
+#	python3 tools/clockctl.py -p PORT watch
+#	python3 tools/clockctl.py -p PORT capture > capture.txt
+#
+# A capture holds the receiver samples as the clock took them, one line a second:
+#
+#	<host UTC time> <sequence> <60 samples as 0s and 1s, oldest first>
+#
+# The host time, from a clock kept by NTP, is the reference for what the samples should
+# decode to. A gap in the sequence numbers marks samples lost on the link.
+#
+# Opening a serial port normally pulses DTR, which resets an Arduino through its
+# auto-reset capacitor. That would lose any setting made without --save. On POSIX
+# systems, the port is left with HUPCL cleared, so DTR stays up after it closes, and
+# later opens don't reset the clock. The first open after plugging in may still reset
+# it. Elsewhere, the port is opened with DTR and RTS held low. Either way, a setting
+# made without --save lasts until the clock next resets or loses power.
+#
+# Needs pyserial.
+
+import argparse
+import datetime
+import math
+import statistics
+import struct
+import sys
+import time
+
+import serial
+
+try:
+	import termios
+except ImportError:
+	termios = None
+
+START = 0xa5
+BAUD = 230400
+TIMEOUT = 1.0
+
+COMMAND_PING = 0x01
+COMMAND_GET_SETTING = 0x02
+COMMAND_SET_SETTING = 0x03
+COMMAND_SAVE = 0x04
+COMMAND_TASK_STATS = 0x05
+COMMAND_PROFILE = 0x06
+COMMAND_MEMORY = 0x07
+COMMAND_METRICS = 0x08
+COMMAND_SAMPLES = 0x09
+COMMAND_ERROR = 0x7f
+COMMAND_REPLY = 0x80
+
+ERRORS = {
+	1: "unknown command",
+	2: "bad length",
+	3: "bad index",
+	4: "out of range",
+	5: "busy, try again",
+}
+
+# Setting names, in the order of the firmware's settings table.
+SETTINGS = [
+	"tz_hours",
+	"tz_minutes",
+	"observe_dst",
+	"override_saved",
+	"score_threshold",
+	"seek_threshold",
+	"miss_threshold",
+	"capture",
+	"seconds_duty",
+]
+
+# Profiler segments, in the order of the firmware's PROFILE_* indexes.
+PROFILE_SEGMENTS = [
+	"tick latency",
+	"tick ISR",
+	"correlate",
+	"decode",
+	"task",
+]
+
+# Bits by which the nearest two symbol patterns differ (zero and one, or one and marker).
+PATTERN_DISTANCE = 18
+
+# MetricsReport: DecoderMetrics, then the running totals.
+METRICS_FORMAT = "<HHH9HBBBBhHIiBB"
+
+CPU_MHZ = 16
+TIMER1_MHZ = 2
+
+
+class ClockError(Exception):
+	pass
+
+
+def crc16(data, crc=0xffff):
+	# Same as _crc16_update() in avr-libc: polynomial 0xa001, reflected.
+	for byte in data:
+		crc ^= byte
+		for _ in range(8):
+			crc = (crc >> 1) ^ 0xa001 if crc & 1 else crc >> 1
+	return crc
+
+
+def frame(command, payload=b""):
+	body = bytes([len(payload), command]) + payload
+	return bytes([START]) + body + struct.pack("<H", crc16(body))
+
+
+def open_port(port):
+	# See the note on DTR at the top.
+	link = serial.Serial()
+	link.port = port
+	link.baudrate = BAUD
+	link.timeout = TIMEOUT
+	if termios is None:
+		link.dtr = False
+		link.rts = False
+	link.open()
+	if termios is not None:
+		attributes = termios.tcgetattr(link.fd)
+		attributes[2] &= ~termios.HUPCL
+		termios.tcsetattr(link.fd, termios.TCSANOW, attributes)
+	return link
+
+
+class Clock:
+	def __init__(self, port):
+		self.port = port
+		self.serial = open_port(port)
+		self.serial.reset_input_buffer()
+		# If opening the port did reset the board, wait for the bootloader and setup.
+		try:
+			self.ping()
+		except ClockError:
+			time.sleep(2)
+			self.serial.reset_input_buffer()
+
+	def close(self):
+		self.serial.close()
+
+	def read_frame(self):
+		# Skip the debug text until a good frame turns up.
+		deadline = time.monotonic() + TIMEOUT
+		while time.monotonic() < deadline:
+			byte = self.serial.read(1)
+			if not byte or byte[0] != START:
+				continue
+			header = self.serial.read(2)
+			if len(header) < 2:
+				continue
+			length, command = header
+			rest = self.serial.read(length + 2)
+			if len(rest) < length + 2:
+				continue
+			payload = rest[:length]
+			if crc16(header + payload) != struct.unpack("<H", rest[length:])[0]:
+				continue
+			return command, payload
+		raise ClockError("%s: no reply" % self.port)
+
+	def request(self, command, payload=b""):
+		self.serial.write(frame(command, payload))
+		# Skip frames sent unasked, like the minute's metrics.
+		while True:
+			reply, data = self.read_frame()
+			if reply == COMMAND_ERROR and data[0] == command:
+				raise ClockError("%s: %s" % (self.port, ERRORS.get(data[1], "error %d" % data[1])))
+			if reply == command | COMMAND_REPLY:
+				return data
+
+	def ping(self):
+		return self.request(COMMAND_PING)[0]
+
+	def get(self, index):
+		return struct.unpack("<Bh", self.request(COMMAND_GET_SETTING, bytes([index])))[1]
+
+	def set(self, index, value):
+		return struct.unpack("<Bh", self.request(COMMAND_SET_SETTING, struct.pack("<Bh", index, value)))[1]
+
+	def save(self):
+		# The journal may still be writing the last save.
+		for _ in range(10):
+			try:
+				return self.request(COMMAND_SAVE)
+			except ClockError as e:
+				if "busy" not in str(e):
+					raise
+				time.sleep(0.1)
+		raise ClockError("%s: save still busy" % self.port)
+
+	def tasks(self):
+		index = 0
+		count = 1
+		while index < count:
+			data = self.request(COMMAND_TASK_STATS, bytes([index]))
+			index, count = data[0], data[1]
+			stats = struct.unpack("<IIIIH", data[2:20])
+			yield (data[20:].decode("ascii"),) + stats
+			index += 1
+
+	def metrics(self):
+		return decode_metrics(self.request(COMMAND_METRICS))
+
+	def watch(self):
+		# The clock sends its metrics at the end of each minute.
+		while True:
+			try:
+				reply, data = self.read_frame()
+			except ClockError:
+				continue
+			if reply == COMMAND_METRICS | COMMAND_REPLY:
+				yield decode_metrics(data)
+
+	def capture(self):
+		self.set(SETTINGS.index("capture"), 1)
+		try:
+			while True:
+				try:
+					reply, data = self.read_frame()
+				except ClockError:
+					continue
+				if reply == COMMAND_SAMPLES | COMMAND_REPLY:
+					sequence = struct.unpack("<H", data[:2])[0]
+					bits = int.from_bytes(data[2:10], "little")
+					yield sequence, "".join("1" if bits >> i & 1 else "0" for i in range(60))
+		finally:
+			self.set(SETTINGS.index("capture"), 0)
+
+	def memory(self):
+		return struct.unpack("<HHHH", self.request(COMMAND_MEMORY))
+
+	def profile(self, reset=False):
+		index = 0
+		count = 1
+		while index < count:
+			data = self.request(COMMAND_PROFILE, bytes([index, 1 if reset else 0]))
+			index, count = data[0], data[1]
+			runs, shortest, longest, mean = struct.unpack("<IHHH", data[2:12])
+			histogram = struct.unpack("<%dH" % ((len(data) - 12) // 2), data[12:])
+			yield index, runs, shortest, longest, mean, histogram
+			index += 1
+
+
+def decode_metrics(data):
+	fields = struct.unpack(METRICS_FORMAT, data)
+	names = ["detected", "missed", "margin_total"]
+	metrics = dict(zip(names, fields[:3]))
+	metrics["peak_scores"] = fields[3:12]
+	names = ["seek_to_sync", "sync_to_seek", "frames_attempted", "frames_valid",
+		"phase_correction", "phase_correction_abs", "seconds_since_fix",
+		"total_phase_correction", "mode", "fix"]
+	metrics.update(zip(names, fields[12:]))
+	metrics["mean_margin"] = metrics["margin_total"] / metrics["detected"] if metrics["detected"] else 0
+	metrics["snr_db"] = snr_estimate(metrics["mean_margin"])
+	return metrics
+
+
+def snr_estimate(margin):
+	# Rough SNR per sample, in dB. With a sample error rate p, the winning pattern beats the
+	# nearest other one by PATTERN_DISTANCE * (1 - 2p) bits on average; for a hard-decision
+	# channel, p = Q(sqrt(2 SNR)).
+	p = (1 - margin / PATTERN_DISTANCE) / 2
+	# Clamped, as the margins can't resolve very clean or very noisy signals.
+	p = min(max(p, 1e-4), 0.45)
+	x = statistics.NormalDist().inv_cdf(1 - p)
+	return 10 * math.log10(x * x / 2)
+
+
+def format_metrics(port, m):
+	since = "never" if m["seconds_since_fix"] == 0xffffffff else "%ds ago" % m["seconds_since_fix"]
+	return ("%s: symbols %d detected, %d missed; margin %.1f bits, SNR ~%.1f dB; "
+		"frames %d/%d valid; seek->sync %d, sync->seek %d; phase %+d (%d) ticks, %+d total; "
+		"fix %s; scores %s" % (port, m["detected"], m["missed"], m["mean_margin"], m["snr_db"],
+		m["frames_valid"], m["frames_attempted"], m["seek_to_sync"], m["sync_to_seek"],
+		m["phase_correction"], m["phase_correction_abs"], m["total_phase_correction"],
+		since, " ".join(str(n) for n in m["peak_scores"])))
+
+
+def setting_index(name):
+	if name not in SETTINGS:
+		raise ClockError("unknown setting %s; one of %s" % (name, ", ".join(SETTINGS)))
+	return SETTINGS.index(name)
+
+
+def run(clock, args):
+	clock.ping()
+
+	if args.action == "get":
+		for name in args.items or SETTINGS:
+			print("%s: %s=%d" % (clock.port, name, clock.get(setting_index(name))))
+
+	elif args.action == "set":
+		for item in args.items:
+			name, _, value = item.partition("=")
+			value = clock.set(setting_index(name), int(value, 0))
+			print("%s: %s=%d" % (clock.port, name, value))
+		if args.save:
+			clock.save()
+			print("%s: saved" % clock.port)
+
+	elif args.action == "save":
+		clock.save()
+		print("%s: saved" % clock.port)
+
+	elif args.action == "tasks":
+		print("%s:" % clock.port)
+		print("  %-8s %10s %10s %10s %10s %6s" % ("task", "runs", "mean us", "max us", "latency us", "missed"))
+		for name, runs, mean, longest, latency, missed in clock.tasks():
+			print("  %-8s %10d %10.1f %10.1f %10.1f %6d" % (name, runs,
+				mean / CPU_MHZ, longest / CPU_MHZ, latency / CPU_MHZ, missed))
+
+	elif args.action == "metrics":
+		print(format_metrics(clock.port, clock.metrics()))
+
+	elif args.action == "watch":
+		for metrics in clock.watch():
+			print(time.strftime("%Y-%m-%d %H:%M:%S"), format_metrics(clock.port, metrics), flush=True)
+
+	elif args.action == "capture":
+		for sequence, samples in clock.capture():
+			now = datetime.datetime.now(datetime.timezone.utc)
+			print("%s %5d %s" % (now.strftime("%Y-%m-%dT%H:%M:%S.%f")[:-3] + "Z", sequence, samples),
+				flush=True)
+
+	elif args.action == "memory":
+		static, region, high_water, free = clock.memory()
+		print("%s: %d bytes static; stack %d of %d bytes at most, %d free now" % (clock.port,
+			static, high_water, region, free))
+
+	elif args.action == "profile":
+		print("%s:" % clock.port)
+		for index, runs, shortest, longest, mean, histogram in clock.profile(args.reset):
+			name = PROFILE_SEGMENTS[index] if index < len(PROFILE_SEGMENTS) else "segment %d" % index
+			print("  %-12s %8d runs, min %.1fus, mean %.1fus, max %.1fus" % (name, runs,
+				shortest / TIMER1_MHZ, mean / TIMER1_MHZ, longest / TIMER1_MHZ))
+			for bucket, n in enumerate(histogram):
+				if n:
+					low = 0 if bucket == 0 else 1 << (bucket - 1)
+					high = (1 << bucket) - 1
+					print("    %8.1f - %8.1fus %6d" % (low / TIMER1_MHZ, high / TIMER1_MHZ, n))
+
+
+def main():
+	parser = argparse.ArgumentParser(description="Read and change nixie clock settings.")
+	parser.add_argument("-p", "--port", action="append", required=True, help="serial port; repeat for more clocks")
+	parser.add_argument("--save", action="store_true", help="save to EEPROM after set")
+	parser.add_argument("--reset", action="store_true", help="reset the profile after reading")
+	parser.add_argument("action", choices=["get", "set", "save", "tasks", "profile", "memory", "metrics", "watch", "capture"])
+	parser.add_argument("items", nargs="*", metavar="NAME[=VALUE]")
+	args = parser.parse_args()
+
+	failed = False
+	for port in args.port:
+		try:
+			clock = Clock(port)
+			try:
+				run(clock, args)
+			finally:
+				clock.close()
+		except (ClockError, serial.SerialException, ValueError) as e:
+			print(e, file=sys.stderr)
+			failed = True
+
+	sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+	main()
@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+# Generates ColorTables.cpp: the colour ramps for time of day and day of year, with
+# gamma correction and brightness baked in, for PROGMEM.
+#
+# Usage: python3 tools/colortables.py > ColorTables.cpp
+
+# Perceptual to PWM exponent for the WS2812 pixels
+GAMMA = 2.6
+
+# Peak channel value. The backlight and colon pixels are close to the tubes, and
+# full power swamps them.
+BRIGHTNESS = 96
+
+# Minutes per entry of the time of day table
+MINUTE_STEP = 4
+
+RED = (1, 0, 0)
+GREEN = (0, 1, 0)
+BLUE = (0, 0, 1)
+
+
+def correct(v):
+	return int(round(BRIGHTNESS * (v ** GAMMA)))
+
+
+# Colour a fraction f of the way around the cycle red - a - b - red, with equal thirds.
+# Like a hue wheel, the next colour comes up to full before the last one goes down, so
+# the ramp holds its brightness. Blending is done on perceptual values, so it looks even.
+def cycle(f, a, b):
+	stops = [RED, a, b, RED]
+	third = min(int(f * 3), 2)
+	t = f * 3 - third
+	w0 = min(1.0, 2 * (1 - t))
+	w1 = min(1.0, 2 * t)
+	c0 = stops[third]
+	c1 = stops[third + 1]
+	return tuple(correct(max(c0[i] * w0, c1[i] * w1)) for i in range(3))
+
+
+def table(name, size, colors, comment):
+	out = []
+	out.append("// %s" % comment)
+	out.append("const uint8_t %s[%s][3] PROGMEM = {" % (name, size))
+	for i in range(0, len(colors), 6):
+		row = colors[i:i + 6]
+		out.append("\t" + " ".join("{ %3d, %3d, %3d }," % c for c in row))
+	out.append("};")
+	return "\n".join(out)
+
+
+# Midnight to 8:00am, red to blue; to 4:00pm, blue to green; to midnight, green to red.
+minutes = [cycle(m * MINUTE_STEP / 1440.0, BLUE, GREEN) for m in range(1440 // MINUTE_STEP)]
+
+# Counting back from the end of the year: red to blue, blue to green, green to red.
+days = [cycle((366 - n) / 366.0, BLUE, GREEN) for n in range(1, 367)]
+
+print("// Generated by tools/colortables.py. Do not edit; change the script and rerun it.")
+print("// Gamma %.1f, peak %d." % (GAMMA, BRIGHTNESS))
+print("")
+print('#include "ColorTables.h"')
+print("")
+print(table("MINUTE_COLORS", "MINUTE_COLOR_COUNT", minutes,
+	"Time of day, one entry per %d minutes from midnight" % MINUTE_STEP))
+print("")
+print(table("DAY_COLORS", "DAY_COLOR_COUNT", days,
+	"Day of year, from day 1"))
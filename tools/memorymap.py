@@ -0,0 +1,57 @@
+#!/usr/bin/env python3
+# Lists the objects in SRAM, largest first, from the linked firmware. Objects in .data
+# take flash for their initial values as well.
+#
+# Usage: python3 tools/memorymap.py NixieClock.ino.elf [--objdump avr-objdump]
+#
+# The Arduino IDE leaves the ELF file in its build directory; "Export compiled Binary"
+# puts a copy next to the sketch.
+
+import argparse
+import re
+import subprocess
+import sys
+
+SRAM_SIZE = 2048
+SRAM_SECTIONS = (".data", ".bss", ".noinit")
+
+# objdump -t line: address, flags, section, size, name
+SYMBOL = re.compile(r"^([0-9a-f]+)\s+(.{7})\s+(\S+)\s+([0-9a-f]+)\s+(.*)$")
+
+
+def symbols(elf, objdump):
+	output = subprocess.run([objdump, "-t", "-C", elf], check=True,
+		stdout=subprocess.PIPE, universal_newlines=True).stdout
+	for line in output.splitlines():
+		match = SYMBOL.match(line)
+		if not match:
+			continue
+		address, flags, section, size, name = match.groups()
+		if section in SRAM_SECTIONS and "O" in flags:
+			yield section, int(size, 16), name
+
+
+def main():
+	parser = argparse.ArgumentParser(description="Report SRAM use by object.")
+	parser.add_argument("elf")
+	parser.add_argument("--objdump", default="avr-objdump")
+	args = parser.parse_args()
+
+	objects = sorted(symbols(args.elf, args.objdump), key=lambda s: -s[1])
+	totals = dict((section, 0) for section in SRAM_SECTIONS)
+
+	print("%6s  %-8s %s" % ("bytes", "section", "object"))
+	for section, size, name in objects:
+		print("%6d  %-8s %s" % (size, section, name))
+		totals[section] += size
+
+	static = sum(totals.values())
+	print()
+	for section in SRAM_SECTIONS:
+		print("%6d  %s" % (totals[section], section))
+	print("%6d  static, of %d" % (static, SRAM_SIZE))
+	print("%6d  left for the stack" % (SRAM_SIZE - static))
+
+
+if __name__ == "__main__":
+	sys.exit(main())
@@ -0,0 +1,10 @@
+// Stand-in for the Arduino core, for building the decoder on a host. It needs only the
+// fixed-width types and the memory functions.
+#ifndef Arduino_h
+#define Arduino_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#endif
@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+# Writes the synthetic replay cases: WWVB receiver output as the clock would sample it,
+# with noise, fading, interference, a drifting local clock, and frames across the DST
+# changes. Each case has its own seed, so the corpus comes out the same every time.
+#
+# Usage: python3 tools/replay/gencorpus.py DIRECTORY
+#
+# The cases are in the capture format of tools/clockctl.py, with the time each line's
+# last sample was taken.
+
+import argparse
+import datetime
+import math
+import os
+import random
+
+SAMPLE_RATE = 60
+
+# Pulse widths, in seconds: the receiver output is high for the start of each second
+WIDTH_ZERO = 0.2
+WIDTH_ONE = 0.5
+WIDTH_MARKER = 0.8
+
+MARKERS = (0, 9, 19, 29, 39, 49, 59)
+
+
+def nth_sunday(year, month, n):
+	first = datetime.date(year, month, 1)
+	return first + datetime.timedelta(days=(6 - first.weekday()) % 7 + 7 * (n - 1))
+
+
+def dst_code(date):
+	# US rule. Bit 1 is DST at the end of the UTC day, and bit 0 at its start.
+	begins = nth_sunday(date.year, 3, 2)
+	ends = nth_sunday(date.year, 11, 1)
+	at_start = begins < date <= ends
+	at_end = begins <= date < ends
+	return (2 if at_end else 0) | (1 if at_start else 0)
+
+
+def bcd(value, weights):
+	bits = []
+	for weight in weights:
+		if weight == 0:
+			bits.append(0)
+		elif value >= weight:
+			bits.append(1)
+			value -= weight
+		else:
+			bits.append(0)
+	return bits
+
+
+def frame(start):
+	# Symbols of the frame starting at a UTC minute: 0, 1, or "M"
+	day = start.timetuple().tm_yday
+	year = start.year % 100
+	leap = start.year % 4 == 0 and (start.year % 100 != 0 or start.year % 400 == 0)
+	dst = dst_code(start.date())
+
+	bits = [0] * 60
+	bits[1:9] = bcd(start.minute, (40, 20, 10, 0, 8, 4, 2, 1))
+	bits[12:19] = bcd(start.hour, (20, 10, 0, 8, 4, 2, 1))
+	bits[22:29] = bcd(day, (200, 100, 0, 80, 40, 20, 10))
+	bits[30:34] = bcd(day % 10, (8, 4, 2, 1))
+	bits[36:39] = [0, 1, 0]					# DUT1 negative
+	bits[45:49] = bcd(year // 10 * 10, (80, 40, 20, 10))
+	bits[50:54] = bcd(year % 10, (8, 4, 2, 1))
+	bits[55] = 1 if leap else 0
+	bits[57] = dst >> 1
+	bits[58] = dst & 1
+
+	symbols = bits
+	for position in MARKERS:
+		symbols[position] = "M"
+	return symbols
+
+
+def level(time, frames):
+	# Receiver output at a UTC time, in seconds from the epoch
+	second = math.floor(time)
+	minute = second - second % 60
+	if minute not in frames:
+		frames[minute] = frame(datetime.datetime.fromtimestamp(minute, datetime.timezone.utc))
+	symbol = frames[minute][second - minute]
+	width = WIDTH_MARKER if symbol == "M" else WIDTH_ONE if symbol == 1 else WIDTH_ZERO
+	return 1 if time - second < width else 0
+
+
+def generate(path, seed, start, minutes, ppm=0, flip=None, bursts=0):
+	# flip: probability of a flipped sample, given the time since the start.
+	# bursts: mean interference bursts a second, each holding the output high.
+	rng = random.Random(seed)
+	period = 1 / (SAMPLE_RATE * (1 + ppm * 1e-6))
+	t0 = start.timestamp() + rng.random()
+	frames = {}
+	burst_left = 0
+	sequence = rng.randrange(0x10000)
+
+	with open(path, "w") as out:
+		out.write("# Synthetic, seed %d. See gencorpus.py.\n" % seed)
+		n = 0
+		for line in range(minutes * 60):
+			samples = []
+			for i in range(SAMPLE_RATE):
+				time = t0 + n * period
+				value = level(time, frames)
+				if flip is not None and rng.random() < flip(time - t0):
+					value ^= 1
+				if bursts and burst_left == 0 and rng.random() < bursts / SAMPLE_RATE:
+					burst_left = rng.randint(2, 8)
+				if burst_left:
+					value = 1
+					burst_left -= 1
+				samples.append(str(value))
+				n += 1
+
+			# Stamped a little after the last sample, as over the serial link
+			stamp = datetime.datetime.fromtimestamp(time + 0.01 + rng.random() * 0.02, datetime.timezone.utc)
+			out.write("%s %5d %s\n" % (stamp.strftime("%Y-%m-%dT%H:%M:%S.%f")[:-3] + "Z", sequence,
+				"".join(samples)))
+			sequence = (sequence + 1) & 0xffff
+
+
+def utc(*fields):
+	return datetime.datetime(*fields, tzinfo=datetime.timezone.utc)
+
+
+def main():
+	parser = argparse.ArgumentParser(description="Write the synthetic replay cases.")
+	parser.add_argument("directory")
+	args = parser.parse_args()
+	os.makedirs(args.directory, exist_ok=True)
+
+	def case(name):
+		return os.path.join(args.directory, name + ".txt")
+
+	generate(case("clean"), 1, utc(2026, 6, 14, 17, 3, 27), 6)
+	generate(case("noisy"), 2, utc(2026, 1, 20, 4, 41, 9), 8, flip=lambda t: 0.06)
+	# Deep fades every five minutes, down to a coin toss
+	generate(case("fading"), 3, utc(2026, 9, 2, 10, 12, 50), 10,
+		flip=lambda t: 0.02 + 0.48 * max(0.0, math.sin(2 * math.pi * t / 300)) ** 4)
+	generate(case("interference"), 4, utc(2026, 12, 31, 23, 56, 33), 8, flip=lambda t: 0.01, bursts=0.5)
+	generate(case("drift"), 5, utc(2028, 2, 29, 8, 30, 15), 8, ppm=500, flip=lambda t: 0.01)
+	# Across 00:00Z into the days DST begins and ends
+	generate(case("dst_begin"), 6, utc(2026, 3, 7, 23, 55, 41), 6, flip=lambda t: 0.01)
+	generate(case("dst_end"), 7, utc(2026, 10, 31, 23, 55, 2), 6, flip=lambda t: 0.01)
+
+
+if __name__ == "__main__":
+	main()
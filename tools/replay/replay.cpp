@@ -0,0 +1,331 @@
+// Replays receiver samples through WwvbDecoder, and checks the frames it decodes against
+// the times the samples were taken.
+//
+// Usage:
+//	replay [--update] BASELINE CASE...
+//
+// A case is a capture from tools/clockctl.py, or a synthetic one from gencorpus.py, one
+// line a second:
+//
+//	<UTC time> <sequence> <60 samples as 0s and 1s, oldest first>
+//
+// The time on each line is when its last sample was taken, give or take the serial link.
+// Lines starting with '#' are comments.
+//
+// For each case, the runner reports the time from the first sample to the first correct
+// frame, the frames decoded, and the false decodes: frames whose time is more than
+// FALSE_DECODE_MS from when the samples were taken, or whose date, leap year or DST code
+// don't hold up. The DST code is checked against the US rule.
+//
+// The baseline holds the same figures for each case. A case that fixes later, decodes
+// fewer frames or decodes more falsely than its baseline, or has none, fails the run.
+// --update rewrites the baseline from this run instead.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "WwvbDecoder.h"
+
+// A decoded time further than this from the sample time is false.
+static const int64_t FALSE_DECODE_MS = 2000;
+
+static const int MAX_CASES = 100;
+static const int NAME_LENGTH = 64;
+static const int LINE_LENGTH = 256;
+
+typedef struct {
+	char name[NAME_LENGTH];
+	int32_t fixSeconds;			// -1 for no fix
+	int32_t frames;				// Correct frames
+	int32_t falseDecodes;
+	int32_t lines;
+	int32_t gaps;				// Breaks in the sequence numbers
+} Result;
+
+// Days from 1970-01-01 to a date. From Howard Hinnant's date algorithms.
+static int64_t daysFromCivil(int64_t year, int month, int day) {
+	year -= month <= 2;
+	int64_t era = (year >= 0 ? year : year - 399) / 400;
+	int64_t yearOfEra = year - era * 400;
+	int64_t dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+	int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+	return era * 146097 + dayOfEra - 719468;
+}
+
+static int64_t floorDiv(int64_t a, int64_t b) {
+	return a / b - (a % b != 0  &&  (a < 0) != (b < 0));
+}
+
+static bool isLeapYear(int64_t year) {
+	return (year % 4 == 0  &&  year % 100 != 0)  ||  year % 400 == 0;
+}
+
+static int64_t yearOfDays(int64_t days) {
+	int64_t year = 1970 + floorDiv(days, 366);
+	while (daysFromCivil(year + 1, 1, 1) <= days)
+		year++;
+	return year;
+}
+
+// The nth Sunday of a month, in days from 1970-01-01. That was a Thursday.
+static int64_t nthSunday(int64_t year, int month, int n) {
+	int64_t first = daysFromCivil(year, month, 1);
+	int64_t weekday = ((first + 4) % 7 + 7) % 7;		// 0 = Sunday
+	return first + (7 - weekday) % 7 + 7 * (n - 1);
+}
+
+// WWVB's DST code for a UTC day, under the US rule: DST from the second Sunday in
+// March to the first Sunday in November. Bit 1 is DST at the end of the day, and bit
+// 0 at its start, so 2 is "begins today", and 1 "ends today".
+static uint8_t dstCode(int64_t days) {
+	int64_t year = yearOfDays(days);
+	int64_t begins = nthSunday(year, 3, 2);
+	int64_t ends = nthSunday(year, 11, 1);
+	bool atStart = days > begins  &&  days <= ends;
+	bool atEnd = days >= begins  &&  days < ends;
+	return (atEnd ? 2 : 0) | (atStart ? 1 : 0);
+}
+
+// Parse an ISO 8601 UTC time, to milliseconds. Returns false if it isn't one.
+static bool parseTime(const char *text, int64_t *ms) {
+	int year, month, day, hours, minutes, seconds, millis;
+	char zone;
+	if (sscanf(text, "%d-%d-%dT%d:%d:%d.%3d%c", &year, &month, &day, &hours, &minutes, &seconds,
+			&millis, &zone) != 8  ||  zone != 'Z')
+		return false;
+
+	*ms = ((daysFromCivil(year, month, day) * 24 + hours) * 60 + minutes) * 60000
+		+ seconds * 1000 + millis;
+	return true;
+}
+
+// Check the frame in the decoder against the time of the sample that completed it.
+static bool frameCorrect(WwvbDecoder *decoder, int64_t sampleMs) {
+	FrameTime frame;
+	decoder->readFrame(&frame);
+
+	if (frame.minutes > 59  ||  frame.hours > 23  ||  frame.day < 1
+			||  frame.day > (isLeapYear(frame.year) ? 366 : 365)
+			||  frame.leapYear != isLeapYear(frame.year))
+		return false;
+
+	int64_t days = daysFromCivil(frame.year, 1, 1) + frame.day - 1;
+	int64_t frameMs = ((days * 24 + frame.hours) * 60 + frame.minutes) * 60000;
+
+	// The frame is the time at its start; its last symbol is decoded in the next minute.
+	int64_t decodedMs = frameMs + 60000 + WwvbDecoder::decodeDelayTicks * 1000 / 60;
+	int64_t error = decodedMs - sampleMs;
+	if (error > FALSE_DECODE_MS  ||  error < -FALSE_DECODE_MS)
+		return false;
+
+	return frame.dst == dstCode(days);
+}
+
+// Run a case through a new decoder. Returns false if the file can't be read.
+static bool replay(const char *path, Result *result) {
+	FILE *file = fopen(path, "r");
+	if (file == NULL) {
+		perror(path);
+		return false;
+	}
+
+	const char *base = strrchr(path, '/');
+	base = base != NULL ? base + 1 : path;
+	snprintf(result->name, NAME_LENGTH, "%s", base);
+	char *suffix = strrchr(result->name, '.');
+	if (suffix != NULL)
+		*suffix = 0;
+	result->fixSeconds = -1;
+	result->frames = 0;
+	result->falseDecodes = 0;
+	result->lines = 0;
+	result->gaps = 0;
+
+	WwvbDecoder decoder;
+	char line[LINE_LENGTH];
+	int64_t firstMs = 0;
+	long lastSequence = -1;
+	bool ok = true;
+
+	for (int number = 1;  fgets(line, sizeof(line), file) != NULL;  number++) {
+		if (line[0] == '#'  ||  line[0] == '\n')
+			continue;
+
+		char timeText[40];
+		long sequence;
+		char samples[LINE_LENGTH];
+		int64_t lineMs;
+		if (sscanf(line, "%39s %ld %255s", timeText, &sequence, samples) != 3
+				||  !parseTime(timeText, &lineMs)  ||  strlen(samples) != 60) {
+			fprintf(stderr, "%s:%d: not a capture line\n", path, number);
+			ok = false;
+			break;
+		}
+
+		if (result->lines == 0)
+			firstMs = lineMs - 59 * 1000 / 60;
+		else if (sequence != ((lastSequence + 1) & 0xffff))
+			result->gaps++;
+		lastSequence = sequence;
+		result->lines++;
+
+		for (int i = 0;  i < 60;  i++) {
+			int64_t sampleMs = lineMs - (59 - i) * 1000 / 60;
+
+			decoder.correlate(samples[i] == '1');
+			if (!(decoder.decode() & WwvbDecoder::EVENT_FRAME))
+				continue;
+
+			if (!frameCorrect(&decoder, sampleMs)) {
+				result->falseDecodes++;
+				continue;
+			}
+			result->frames++;
+			if (result->fixSeconds < 0)
+				result->fixSeconds = (int32_t)((sampleMs - firstMs + 500) / 1000);
+		}
+	}
+
+	fclose(file);
+	return ok;
+}
+
+// Read the baseline. A missing file is an empty baseline.
+static int readBaseline(const char *path, Result *baseline) {
+	FILE *file = fopen(path, "r");
+	if (file == NULL)
+		return 0;
+
+	char line[LINE_LENGTH];
+	int count = 0;
+	while (count < MAX_CASES  &&  fgets(line, sizeof(line), file) != NULL) {
+		if (line[0] == '#'  ||  line[0] == '\n')
+			continue;
+
+		Result *entry = &baseline[count];
+		char fix[16];
+		if (sscanf(line, "%63s %15s %d %d", entry->name, fix, &entry->frames, &entry->falseDecodes) != 4)
+			continue;
+		entry->fixSeconds = strcmp(fix, "-") == 0 ? -1 : atoi(fix);
+		count++;
+	}
+
+	fclose(file);
+	return count;
+}
+
+static bool writeBaseline(const char *path, const Result *results, int count) {
+	FILE *file = fopen(path, "w");
+	if (file == NULL) {
+		perror(path);
+		return false;
+	}
+
+	fprintf(file, "# Replay baseline: case, seconds to the first correct frame (- for none),\n");
+	fprintf(file, "# correct frames, false decodes. Rewrite with \"make baseline\".\n");
+	for (int i = 0;  i < count;  i++) {
+		if (results[i].fixSeconds < 0)
+			fprintf(file, "%s\t-\t%d\t%d\n", results[i].name, results[i].frames, results[i].falseDecodes);
+		else
+			fprintf(file, "%s\t%d\t%d\t%d\n", results[i].name, results[i].fixSeconds, results[i].frames,
+				results[i].falseDecodes);
+	}
+
+	fclose(file);
+	return true;
+}
+
+static void formatFix(int32_t seconds, char *text, size_t size) {
+	if (seconds < 0)
+		snprintf(text, size, "-");
+	else
+		snprintf(text, size, "%ds", seconds);
+}
+
+// Compare a result to its baseline. Returns false on a regression, saying what in status.
+static bool compare(const Result *result, const Result *base, char *status, size_t size) {
+	if (base == NULL) {
+		snprintf(status, size, "NEW: not in the baseline");
+		return false;
+	}
+
+	char fix[16];
+	char baseFix[16];
+	formatFix(result->fixSeconds, fix, sizeof(fix));
+	formatFix(base->fixSeconds, baseFix, sizeof(baseFix));
+
+	if (base->fixSeconds >= 0  &&  (result->fixSeconds < 0  ||  result->fixSeconds > base->fixSeconds)) {
+		snprintf(status, size, "REGRESSED: fix %s, was %s", fix, baseFix);
+		return false;
+	}
+	if (result->frames < base->frames) {
+		snprintf(status, size, "REGRESSED: %d frames, was %d", result->frames, base->frames);
+		return false;
+	}
+	if (result->falseDecodes > base->falseDecodes) {
+		snprintf(status, size, "REGRESSED: %d false, was %d", result->falseDecodes, base->falseDecodes);
+		return false;
+	}
+
+	if (result->fixSeconds != base->fixSeconds  ||  result->frames != base->frames
+			||  result->falseDecodes != base->falseDecodes)
+		snprintf(status, size, "better; baseline fix %s, %d frames, %d false", baseFix, base->frames, base->falseDecodes);
+	else
+		snprintf(status, size, "ok");
+	return true;
+}
+
+int main(int argc, char **argv) {
+	bool update = false;
+	int arg = 1;
+	if (arg < argc  &&  strcmp(argv[arg], "--update") == 0) {
+		update = true;
+		arg++;
+	}
+	if (argc - arg < 2) {
+		fprintf(stderr, "Usage: %s [--update] BASELINE CASE...\n", argv[0]);
+		return 2;
+	}
+
+	const char *baselinePath = argv[arg++];
+	static Result results[MAX_CASES];
+	static Result baseline[MAX_CASES];
+	int count = 0;
+
+	for (;  arg < argc;  arg++) {
+		if (count == MAX_CASES) {
+			fprintf(stderr, "More than %d cases\n", MAX_CASES);
+			return 2;
+		}
+		if (!replay(argv[arg], &results[count]))
+			return 2;
+		count++;
+	}
+
+	if (update)
+		return writeBaseline(baselinePath, results, count) ? 0 : 2;
+
+	int baselineCount = readBaseline(baselinePath, baseline);
+	bool passed = true;
+
+	printf("%-16s %5s %6s %6s %6s %5s  %s\n", "case", "lines", "gaps", "fix", "frames", "false", "against baseline");
+	for (int i = 0;  i < count;  i++) {
+		const Result *base = NULL;
+		for (int j = 0;  j < baselineCount;  j++) {
+			if (strcmp(baseline[j].name, results[i].name) == 0)
+				base = &baseline[j];
+		}
+
+		char fix[16];
+		char status[80];
+		formatFix(results[i].fixSeconds, fix, sizeof(fix));
+		if (!compare(&results[i], base, status, sizeof(status)))
+			passed = false;
+		printf("%-16s %5d %6d %6s %6d %5d  %s\n", results[i].name, results[i].lines, results[i].gaps,
+			fix, results[i].frames, results[i].falseDecodes, status);
+	}
+
+	if (!passed)
+		printf("Replay check failed.\n");
+	return passed ? 0 : 1;
+}